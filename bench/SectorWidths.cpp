@@ -0,0 +1,184 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			SectorWidths.cpp
+// Programmer:			Matthew Hydock
+//
+// File description:	Times Galaxy::fitArcWidths against the insertion sort
+//						and shuffle adjustSectorWidths used to do, on made-up
+//						sectors with a few big directories and many small
+//						ones. Built with "make sectorbench".
+//==============================================================================
+
+#include "Galaxy.h"
+#include <sys/time.h>
+
+//==============================================================================
+// Helpers.
+//==============================================================================
+// A stand-in for a sector: its width, and the least it can have.
+struct BenchSector
+{
+	float width;
+	float floor;
+};
+
+static double now()
+// The current time, in seconds.
+{
+	struct timeval t;
+	gettimeofday(&t,NULL);
+
+	return t.tv_sec + t.tv_usec/1000000.0;
+}
+
+static void oldAdjust(list<BenchSector*>* sectors)
+// The old way: insertion sort the sectors by width, then raise each one under
+// its floor, taking the difference evenly out of every sector after it.
+{
+	list<BenchSector*> temp;
+	list<BenchSector*>::iterator i = sectors->begin();
+	list<BenchSector*>::iterator j;
+
+	temp.push_back(*i);
+	i++;
+
+	while (temp.size() < sectors->size())
+	{
+		j = temp.begin();
+		while (j != temp.end() && (*i)->width > (*j)->width)
+			j++;
+
+		temp.insert(j,*i);
+		i++;
+	}
+
+	for (i = temp.begin(); i != temp.end() && (*i)->width < (*i)->floor; i++)
+	{
+		float diff = (*i)->floor - (*i)->width;
+		(*i)->width += diff;
+
+		int remain = -1;
+		for (j = i; j != temp.end(); j++)
+			remain++;
+
+		j = i;
+		for (j++; j != temp.end(); j++)
+			(*j)->width -= diff/remain;
+	}
+}
+
+static void makeSectors(int n, float floor_total, MTRand* r, vector<float>* widths, vector<float>* floors)
+// Make n sectors, sized like directories (mostly small, a few very big), with
+// floors that add up to floor_total degrees.
+{
+	double width_sum = 0;
+	double floor_sum = 0;
+
+	widths->resize(n);
+	floors->resize(n);
+
+	for (int i = 0; i < n; i++)
+	{
+		(*widths)[i] = floor(1.0/pow(r->rand()+0.0001,1.2));
+		(*floors)[i] = 1 + r->rand();
+
+		width_sum += (*widths)[i];
+		floor_sum += (*floors)[i];
+	}
+
+	for (int i = 0; i < n; i++)
+	{
+		(*widths)[i] *= 360/width_sum;
+		(*floors)[i] *= floor_total/floor_sum;
+	}
+}
+
+static void run(int n, float floor_total, MTRand* r)
+// Time both ways on one set of sectors, and check the new widths.
+{
+	vector<float> widths;
+	vector<float> floors;
+	makeSectors(n,floor_total,r,&widths,&floors);
+
+	// Enough runs to take a few milliseconds.
+	int reps = max(1,200000/n);
+	vector<float> fitted;
+
+	double start = now();
+	for (int k = 0; k < reps; k++)
+	{
+		fitted = widths;
+		Galaxy::fitArcWidths(&fitted,&floors,360);
+	}
+	double fit_time = (now()-start)/reps;
+
+	double sum = 0;
+	int under = 0;
+	float shrink = (floor_total > 360) ? 360/floor_total : 1;
+
+	for (int i = 0; i < n; i++)
+	{
+		sum += fitted[i];
+		if (fitted[i] < floors[i]*shrink - 0.001)
+			under++;
+	}
+
+	// The old way is quadratic, so only the smaller runs are timed.
+	double old_time = -1;
+	int old_under = 0;
+
+	if (n <= 10000)
+	{
+		vector<BenchSector> s(n);
+		list<BenchSector*> l;
+
+		for (int i = 0; i < n; i++)
+		{
+			s[i].width = widths[i];
+			s[i].floor = floors[i];
+			l.push_back(&s[i]);
+		}
+
+		start = now();
+		oldAdjust(&l);
+		old_time = now()-start;
+
+		for (int i = 0; i < n; i++)
+			if (s[i].width < floors[i] - 0.001)
+				old_under++;
+	}
+
+	printf("%8d %9.0f %12.4f %8.2f %6d ",n,floor_total,fit_time*1000,sum,under);
+
+	if (old_time < 0)
+		printf("%12s %6s\n","-","-");
+	else
+		printf("%12.4f %6d\n",old_time*1000,old_under);
+}
+//==============================================================================
+
+
+//==============================================================================
+// Main.
+//==============================================================================
+int main()
+{
+	int sizes[] = {10,100,1000,10000,100000};
+	MTRand r(1);
+
+	printf("%8s %9s %12s %8s %6s %12s %6s\n","sectors","floors","new (ms)","sum","under","old (ms)","under");
+
+	// Floors that fit in the circle, so the widths are sorted and fitted, then
+	// floors of a few degrees each, like real sectors have, which stop
+	// fitting past about 65 sectors and are all shrunk together instead.
+	for (int i = 0; i < 5; i++)
+		run(sizes[i],180,&r);
+
+	for (int i = 0; i < 5; i++)
+		run(sizes[i],sizes[i]*(GALAXY_SECTOR_PADDING+1.5),&r);
+
+	return 0;
+}
+//==============================================================================
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		28 March 2012
-// Last Updated:		29 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			DirNode.h
 // Programmer:			Matthew Hydock
@@ -10,6 +10,7 @@
 
 #include <list>
 #include <string>
+#include <tr1/unordered_map>
 
 #ifndef DIRNODE
 #define DIRNODE
@@ -19,19 +20,85 @@
 
 typedef struct dirent dirent;
 
+class IndexSnapshot;
+
+// Running totals for everything in a directory and below it. They are kept up
+// to date as things are added, removed, or read, so they never have to be
+// counted. Files found by a walk have their attributes read along with the
+// listing, so the sizes and times are whole unless missing_attrs says
+// otherwise. Files whose type hasn't been read count as UNKNOWN.
+struct DirTotals
+{
+	int files;
+	int dirs;
+	long long bytes;
+	long long blocks;
+	time_t newest;
+	int types[UNKNOWN+1];
+	
+	// Directories still waiting to be read out of a snapshot, which aren't
+	// in the totals yet.
+	int unread;
+	
+	// Files whose attributes couldn't be read (or haven't been yet), which
+	// are counted but left out of the sizes and times.
+	int missing_attrs;
+};
+
 class DirNode:public DirNodePrototype
 {
+	friend class FileIterator;
+	friend class TreeArena;
+	
 	private:
 		string name;
 		DirNode* parent;
 		list<FileNode*> files;
 		list<DirNode*> dirs;
 		
+		// The lists are kept in name order, for showing. Each name is also
+		// indexed, so finding, adding, or removing anything doesn't mean
+		// searching the lists.
+		tr1::unordered_map<string,list<FileNode*>::iterator> file_index;
+		tr1::unordered_map<string,list<DirNode*>::iterator> dir_index;
+		
+		// Totals for this directory and everything below it. A file's share of
+		// them is held onto while it changes, so it can be taken back out.
+		// Attached is set while this directory is in its parent's totals.
+		DirTotals totals;
+		DirTotals changing;
+		bool attached;
+		
+		// Where this directory is in its parent's list, while attached.
+		list<DirNode*>::iterator place;
+		
+		time_t mtime;
+		time_t ctime;
+		
+		// If this directory came from a snapshot, its contents are only read
+		// out of the snapshot the first time they are needed.
+		IndexSnapshot* snapshot;
+		int snapshot_index;
+		
+		// This directory's row in the arena, as of the last time it was laid
+		// out (or -1 if never).
+		int row;
+		
+		void expand();
+		
 		list<FileNode*>::iterator findFile(string fn);
 		list<FileNode*>::iterator findFile(FileNode* f);
 		list<DirNode*>::iterator findDirectory(string dn);
 		list<DirNode*>::iterator findDirectory(DirNode* d);
 		
+		void insertFile(FileNode* f);
+		void insertDirectory(DirNode* d);
+		
+		static void fileTotals(FileNode* f, DirTotals* t);
+		void adjustTotals(DirTotals* add, DirTotals* sub);
+		void findNewest();
+		void expandAll();
+		
 	public:
 		DirNode(DirNode* p, string n);
 		~DirNode();
@@ -51,6 +118,9 @@ class DirNode:public DirNodePrototype
 		void deleteDirectory(string dn);
 		void deleteDirectory(DirNode* d);
 		
+		FileNode* getFile(string fn);
+		DirNode* getDirectory(string dn);
+		
 		list<FileNode*>* getFiles();
 		list<DirNode*>* getDirectories();
 		
@@ -61,7 +131,42 @@ class DirNode:public DirNodePrototype
 		void rename(string n);
 		void setParent(DirNode* p);
 		
-		// Convenience method to get all files from this node on down.
-		list<FileNode*>* getAllFiles();
+		void setTimes(time_t m, time_t c);
+		time_t getModifiedTime();
+		time_t getChangedTime();
+		
+		void setSnapshot(IndexSnapshot* s, int i);
+		IndexSnapshot* getSnapshot();
+		int getSnapshotIndex();
+		
+		DirTotals* getTotals();
+		void fileChanging(FileNode* f);
+		void fileChanged(FileNode* f);
+};
+
+// Walks every file in a directory and everything below it, in the order they
+// are listed, without building a list of them. The tree must not change while
+// the walk is going on.
+class FileIterator
+{
+	private:
+		DirNode* top;
+		DirNode* dir;
+		list<FileNode*>::iterator file;
+		
+		// While walking a laid out subtree, the current row of the arena and
+		// the row after the last, otherwise -1.
+		int row;
+		int end;
+		
+		void nextDirectory();
+		void settle();
+		
+	public:
+		FileIterator(DirNode* d);
+		
+		bool done();
+		FileNode* operator*();
+		FileIterator& operator++();
 };
 #endif
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		28 March 2012
-// Last Updated:		29 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			DirNodePrototype.h
 // Programmer:			Matthew Hydock
@@ -18,6 +18,8 @@ using namespace std;
 #ifndef DIRNODE_PROTOTYPE
 #define DIRNODE_PROTOTYPE
 
+class FileNode;
+
 class DirNodePrototype
 {
 	public:
@@ -26,6 +28,11 @@ class DirNodePrototype
 		virtual string getName() = 0;
 		virtual string getPath() = 0;
 		virtual DirNodePrototype* getParent() = 0;
+		
+		// Called by a file in this directory just before and just after its
+		// attributes or type change, so the directory's totals can follow.
+		virtual void fileChanging(FileNode* f) = 0;
+		virtual void fileChanged(FileNode* f) = 0;
 };
 
 #endif
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		5 March 2011
-// Last Updated:		29 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			DirTree.h
 // Programmer:			Matthew Hydock
@@ -25,22 +25,25 @@ class DirTree
 		int numfiles;
 		DirNode* root;
 		
+		DirNode* findDir(string p, bool make);
+		
 	public:
 		DirTree(string s);
 		~DirTree();
 		
 		void add(string p, string n);
+		void attach(DirNode* d, vector<FileNode*>* f, vector<DirNode*>* s);
 		DirNode* getDir(string p);
 		FileNode* getFile(string p, string n);
 		
 		void clearTree();
 		void dropBranch(DirNode* d);
+		void layOut();
 		
-		list<FileNode*>* getAllFilesFrom(DirNode* d);
-		list<FileNode*>* getFileList();
 		string getRootPath();
 		DirNode* getRootNode();
 		int getNumFiles();
+		void setNumFiles(int n);
 };
 
 #endif
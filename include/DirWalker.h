@@ -0,0 +1,133 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			DirWalker.h
+// Programmer:			Matthew Hydock
+//
+// File description:	Header for a parallel directory walker. A pool of worker
+//						threads reads directories, each worker taking new sub-
+//						directories from its own deque and stealing from the
+//						other workers' deques when it runs dry. Directories are
+//						opened relative to their parents' descriptors, so whole
+//						paths are only built when they are really needed.
+//==============================================================================
+
+#include "global_header.h"
+#include "DirNode.h"
+
+#include <deque>
+#include <map>
+#include <pthread.h>
+
+#ifndef DIRWALKER
+#define DIRWALKER
+
+// The most directories the walker keeps open at once. Sub-directories are
+// opened as soon as they are found, relative to the directory they are in, and
+// wait in the queues that way. Past this many, they are opened by their full
+// paths when their turn comes instead.
+#define WALK_MAX_FDS 256
+
+// The contents of one directory, as read by a worker. The directory nodes have
+// their parents set, but are not yet attached to the tree; that is left to
+// whoever collects the listings, so the tree is only ever modified by one
+// thread. Workers only read the files' names and attributes; their nodes are
+// made as the listings are collected, as they are given rows in the arena,
+// which only the thread that owns the tree may do.
+struct DirListing
+{
+	DirNode* dir;
+	vector<FileNode*> files;
+	vector<DirNode*> dirs;
+	
+	vector<string> file_names;
+	vector<struct stat> file_attrs;
+	vector<char> have_attrs;
+};
+
+class DirWalker
+{
+	private:
+		// A directory waiting to be read, and its descriptor if it has been
+		// opened already (otherwise -1).
+		struct PendingDir
+		{
+			DirNode* dir;
+			int fd;
+		};
+
+		// One deque of pending directories per worker. The owner pushes and
+		// pops at the back, thieves take from the front.
+		struct WorkQueue
+		{
+			pthread_mutex_t lock;
+			deque<PendingDir> dirs;
+		};
+
+		// Handed to each thread, so it knows which deque is its own.
+		struct WorkerArgs
+		{
+			DirWalker* walker;
+			int id;
+		};
+
+		int num_threads;
+		vector<WorkQueue*> queues;
+		vector<WorkerArgs> args;
+		vector<pthread_t> threads;
+		bool running;
+
+		// Set by stop(), and cleared by start(). Only touched under work_lock,
+		// as the workers read it while the main thread writes it.
+		bool stopping;
+
+		// Number of directories queued or being read. When it hits zero, the
+		// walk is over. The generation counts every directory ever queued, and
+		// is what idle workers wait on.
+		int pending;
+		int generation;
+		pthread_mutex_t work_lock;
+		pthread_cond_t work_cond;
+
+		// Finished listings, in the order they were completed.
+		list<DirListing*> results;
+		pthread_mutex_t results_lock;
+
+		// Running totals, for reporting.
+		int files_found;
+		int dirs_found;
+
+		// Number of directory descriptors held by queued directories.
+		int open_fds;
+
+		static void* workerMain(void* a);
+		void work(int id);
+		bool takeDirectory(int id, PendingDir& d);
+		void pushDirectory(int id, DirNode* d, int fd);
+		void readDirectory(int id, PendingDir d);
+		void closePending(PendingDir d);
+
+	public:
+		DirWalker(int threads = 0);
+		~DirWalker();
+
+		void start(DirNode* root);
+		void start(vector<DirNode*>* roots);
+		void wait();
+		void stop();
+		bool isDone();
+
+		list<DirListing*>* takeResults();
+
+		int getNumThreads();
+		int getFilesFound();
+		int getDirsFound();
+		int getDirsPending();
+
+		static int openDirectory(DirNode* d);
+		static int openDirectory(int fd, string name);
+		static bool listDirectory(int fd, vector<string>* f, vector<string>* d, struct stat* st, map<string,struct stat>* attrs = NULL);
+};
+
+#endif
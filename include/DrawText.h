@@ -1,15 +1,16 @@
 //==============================================================================
 // Date Created:		3 May 2011
-// Last Updated:		15 May 2011
+// Last Updated:		18 October 2026
 //
 // File name:			DrawText.h
 // Programmer:			Matthew Hydock
 //
-// File description:	Header for a class that renders text to a texture.
+// File description:	Header for a class that draws text, a quad per character,
+//						from the glyph atlas of its font.
 //==============================================================================
 
-#include <SDL/SDL_ttf.h>
 #include "Drawable.h"
+#include "FontAtlas.h"
 
 #ifndef DRAWTEXT
 #define DRAWTEXT
@@ -19,6 +20,14 @@
 enum text_align {MIDDLE, LEFT, RIGHT};
 #endif
 
+// One corner of a character's quad, laid out for GL_T2F_V3F. The texture
+// coordinates are in atlas pixels.
+struct TextVertex
+{
+	GLfloat s, t;
+	GLfloat x, y, z;
+};
+
 class DrawText:public Drawable
 {
 	protected:		
@@ -35,7 +44,12 @@ class DrawText:public Drawable
 		float horz_padding;
 		float vert_padding;
 		
-		TextureObject* texture;
+		// The font's atlas, and the text laid out on it, along with the size
+		// it was laid out at.
+		FontAtlas* atlas;
+		vector<TextVertex> vertices;
+		float text_width;
+		float text_height;
 
 	public:
 		DrawText(string t, string f = "/usr/share/fonts/truetype/freefont/FreeSans.ttf", int size = 14, float x = 0, float y = 0, text_align a = MIDDLE);
@@ -79,6 +93,8 @@ class DrawText:public Drawable
 		void setBackgroundColor(float c[4]);
 		float* getBackgroundColor();
 		
+		size_t getByteSize();
+		
 		void initTexture();
 		void refreshTexture();
 		void draw();
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		26 March 2012
-// Last Updated:		29 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			FileNode.h
 // Programmer:			Matthew Hydock
@@ -10,37 +10,74 @@
 
 #include <sys/stat.h>
 #include <dirent.h>
+#include <set>
 
 #include "DirNodePrototype.h"
 #include "MimeIdentifier.h"
+#include "TreeArena.h"
 
 #ifndef FILENODE
 #define FILENODE
 
+// Which parts of a file's metadata have been read. Each part is only read the
+// first time something asks for it.
+#define FILE_HAVE_ATTR 1
+#define FILE_HAVE_TYPE 2
+#define FILE_HAVE_TAGS 4
+#define FILE_HAVE_ALL (FILE_HAVE_ATTR | FILE_HAVE_TYPE | FILE_HAVE_TAGS)
+
+// Set in a file's row of the arena while the file is in its directory's
+// totals. Kept out of the FILE_HAVE_* flags that getKnown() gives.
+#define FILE_COUNTED 0x80
+
 class FileNode
 {
+	// Directories read the attributes straight out of the arena when keeping
+	// totals, so that doing so never causes anything to be read. The arena
+	// moves files' rows when it lays itself out.
+	friend class DirNode;
+	friend class TreeArena;
+	
 	private:
 		static MimeIdentifier mrmime;
 		
-		string name;
-		string mime_type;
-		string default_app;
-		enum filetype mime_enum;
-		struct stat attr;
-		list<string> tags;
+		// The name, attributes, type, and what has been read of every file
+		// are kept in the arena, in this file's row; the node itself only
+		// holds what the arena doesn't. Tags are rare, so they are only given
+		// a list once a file has some.
+		static TreeArena* arena;
 		
 		DirNodePrototype* parent;
+		list<string>* tags;
+		int row;
+		
+		// A slice of a batch passed to prefetchAttributes().
+		struct StatJob
+		{
+			vector<string>* paths;
+			vector<struct stat>* attrs;
+			vector<char>* found;
+			size_t begin;
+			size_t end;
+		};
+		
+		static void* statWorker(void* j);
 		
 		void setTags();
 		void obtainType();
+		void obtainAttributes(struct stat* a = NULL);
+		void readAttributes();
+		void setAttributes(struct stat* a);
 		
 	public:
 		FileNode(DirNodePrototype* p, string n);
+		FileNode(DirNodePrototype* p, string n, struct stat* a, string m, string t, int k = FILE_HAVE_ALL);
 		~FileNode();
 		
 		string getName();
 		string getPath();
 		string getMimetype();
+		const string* getSharedMimetype();
 		string getDefaultApp();
 		
 		void setName(string n);
@@ -50,9 +87,25 @@ class FileNode
 		
 		enum filetype getMimeEnum();
 		struct stat getAttributes();
+		void setType(string m);
 		
+		off_t getSize();
+		blkcnt_t getBlocks();
+		time_t getModifiedTime();
+		mode_t getMode();
+		ino_t getInode();
+		
+		int getKnown();
+		bool hasType();
+		
+		void refresh(struct stat* a = NULL);
 		void rebuildTags();
 		list<string>* getTags();
+		
+		static void prefetch(vector<FileNode*>* f, int threads = 0);
+		static void prefetchAttributes(vector<FileNode*>* f, int threads = 0);
+		
+		static TreeArena* getArena();
 };
 
 #endif	
@@ -0,0 +1,75 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			FontAtlas.h
+// Programmer:			Matthew Hydock
+//
+// File description:	Header for a texture that holds every glyph of one font
+//						at one size. Fonts are opened once, and each font/size
+//						gets one atlas for the life of the program, so text can
+//						be changed without opening files or making textures.
+//==============================================================================
+
+#include <SDL/SDL_ttf.h>
+#include "TextureObject.h"
+
+#include <map>
+#include <vector>
+
+#ifndef FONTATLAS
+#define FONTATLAS
+
+// The width of an atlas, and its height to start with, in pixels. An atlas
+// doubles in height whenever it fills up.
+#define ATLAS_WIDTH 512
+#define ATLAS_START_HEIGHT 64
+
+// Where a glyph is in the atlas, and how far it moves the pen along. Every
+// glyph's cell is as tall as the font's lines, so they line up on the same
+// baseline.
+struct Glyph
+{
+	int x;
+	int y;
+	int w;
+	int advance;
+};
+
+class FontAtlas:public TextureObject
+{
+	private:
+		TTF_Font* font;
+		int line_height;
+
+		// Text is rendered as Latin-1, the way TTF_RenderText reads it, so
+		// there are only ever 256 glyphs. They are rendered as they are first
+		// needed, except for the printable ASCII ones, which are all rendered
+		// when the atlas is made.
+		Glyph glyphs[256];
+		bool rendered[256];
+
+		// The atlas' coverage, kept here so it can be uploaded again after it
+		// grows, and where the next glyph goes.
+		vector<GLubyte> pixels;
+		int pen_x;
+		int pen_y;
+		bool dirty;
+
+		static map<pair<string,int>,FontAtlas*> atlases;
+
+		FontAtlas(TTF_Font* f);
+		void renderGlyph(unsigned char c);
+
+	public:
+		~FontAtlas();
+
+		static FontAtlas* get(string path, int size);
+
+		Glyph* getGlyph(unsigned char c);
+		int getLineHeight();
+
+		void loadTexture();
+};
+
+#endif
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		12 March 2011
-// Last Updated:		30 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			GSector.h
 // Programmer:			Matthew Hydock
@@ -14,9 +14,12 @@
 
 #include "DirNode.h"
 #include "Star.h"
+#include "StarLayout.h"
 
 #include "RenderTextureObject.h"
 
+#include <set>
+
 #ifndef GSECTOR
 #define GSECTOR
 
@@ -33,18 +36,52 @@ class GSector:public LabeledDrawable
 		list<Star*> stars;
 		list<FileNode*>* files;
 		DirNode* root;
+		bool own_files;
+		
+		// The directories folded into the sector, if it stands in for a
+		// number of small ones.
+		list<DirNode*> members;
+		
+		// Where the sector's random star positions start from. It comes from
+		// the sector's directory (or name), so the same sector always lays
+		// its stars out the same way.
+		unsigned long seed;
+		
+		// Where the stars were placed last time, if the galaxy keeps track.
+		StarLayout* layout;
 		
 		float getMinStarDist(Star* s);
+		void placeStar(Star* s, MTRand* r);
+		void keepInside(Star* s);
+		bool restoreStar(Star* s);
 		void clearStars();
+		void init(float ra, float b, float w, string n, StarLayout* l);
 		
 		bool singleSectorMode;
 		
+		// Set once every star's file has had its metadata read.
+		bool warm;
+		
+		// Set whenever the stars change, until the galaxy's star batch has
+		// been rebuilt from them.
+		bool stars_changed;
+		
 	public:
-		GSector(DirNode* r, list<FileNode*>* f, float ra, float b, float w, string n = "");
+		GSector(DirNode* r, list<FileNode*>* f, float ra, float b, float w, string n = "", StarLayout* l = NULL);
+		GSector(list<DirNode*>* m, float ra, float b, float w, string n, StarLayout* l = NULL);
 		~GSector();
 		
 		void buildStars();
+		void placeStrays();
+		void recordLayout();
 		list<Star*>* getStars();
+		bool starsChanged();
+		void markStarsDrawn();
+		
+		void addFiles(list<FileNode*>* f);
+		bool removeFiles(set<FileNode*>* gone);
+		bool refreshFiles(set<FileNode*>* changed);
+		int prefetch(int max = 0, vector<FileNode*>* read = NULL);
 		
 		void setName(string n);
 		string getName();
@@ -55,7 +92,9 @@ class GSector:public LabeledDrawable
 		void setRadius(float r);
 		void setArcBegin(float b);
 		void setArcWidth(float e);
+		void setArc(float b, float w);
 		void setThickness(float t);
+		void rescale(float r, float t);
 		
 		float getRadius();
 		float getArcBegin();
@@ -64,9 +103,16 @@ class GSector:public LabeledDrawable
 		float getThickness();
 		
 		list<FileNode*>* getFileList();
+		void adoptFileList();
 		void setDirectory(DirNode *r);
 		DirNode* getDirectory();
 		
+		void setMembers(list<DirNode*>* m);
+		list<DirNode*>* getMembers();
+		bool isAggregate();
+		bool removeMembers(set<DirNode*>* gone);
+		void addMembers(list<DirNode*>* m);
+		
 		void setSingleSectorMode(bool m);
 		bool isSingleSectorMode();
 		
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		20 February 2011
-// Last Updated:		29 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			Galaxy.h
 // Programmer:			Matthew Hydock
@@ -13,13 +13,50 @@
 //==============================================================================
 
 #include "GSector.h"
+#include "StarBatch.h"
 #include "RenderTextureObject.h"
+#include "TreeChanges.h"
+
+#include <map>
 
 #ifndef GALAXY
 #define GALAXY
 
 enum cluster_type{DIRECTORY,NAME,DATE,SIZE,TYPE,TAGS,NONE};
 
+// How many degrees each sector gets on top of the least it needs to fit its
+// biggest star.
+#define GALAXY_SECTOR_PADDING 4
+
+// The most sectors a galaxy built on directories has by default, and the
+// smallest share of the circle a directory can have (in degrees) before it is
+// folded into a sector with the other small ones.
+#define GALAXY_MAX_SECTORS 64
+#define GALAXY_MIN_SECTOR_ARC 1.0
+
+// How many sectors to aim for when splitting files up by name, date, and so
+// on.
+#define GALAXY_CLUSTER_SECTORS 16
+
+// How many times its fair share of the files a type has to have before it is
+// split up by full mime-type.
+#define GALAXY_TYPE_SPLIT 2
+
+// The most bins files are sorted into by date before they are merged. Dates
+// further back than this many bins from the newest share the first bin.
+#define GALAXY_DATE_MAX_BINS 4096
+
+// How many stars a galaxy can have before they are drawn as point sprites
+// instead of textured quads.
+#define GALAXY_SPRITE_STARS 50000
+
+// How fast galaxies turn, in degrees a second.
+#define GALAXY_ROTATION_SPEED 1.2
+
+// How many stars' metadata can be read in the background before the galaxy's
+// texture is redrawn to show them.
+#define GALAXY_PREFETCH_REDRAW 1024
+
 class Galaxy:public LabeledDrawable
 {
 	private:
@@ -37,19 +74,46 @@ class Galaxy:public LabeledDrawable
 		float radius;
 		float thickness;
 		
-		// Stores galaxy's files and directories.
+		// Stores galaxy's files and directories. A galaxy built on a
+		// directory makes its own file list, and deletes it when done.
 		list<GSector*>* sectors;
 		list<FileNode*>* files;
 		DirNode* root;
+		bool own_files;
+		
+		// The directories the galaxy is built on, when it is made from a
+		// sector that stood in for several of them.
+		list<DirNode*> members;
 		
-		// The available tags in this galaxy.
+		// The available tags in this galaxy. Only the tags of files whose tags
+		// have been read are in it; more are added as the files are prefetched.
+		// A list given from outside (such as the tags picked to sort by) is
+		// left as it is.
 		list<string>* tags;
+		bool own_tags;
 		
 		// The currently selected sector.
 		GSector* selected;
 		
-		// Render to texture.
+		// Render to texture. The stars are drawn into it all at once.
 		RenderTextureObject* texture;
+		StarBatch* batch;
+		
+		// Number of stars whose metadata has been read since the texture was
+		// last rendered.
+		int stale_stars;
+		
+		// Limits on how many sectors a galaxy built on directories has, and
+		// how small they can be. Static, so they are the same for all.
+		static int max_sectors;
+		static float min_sector_arc;
+		
+		// About how many sectors to split files into by name, date, and so
+		// on.
+		static int cluster_sectors;
+		
+		// How many stars a galaxy can have before they are drawn as points.
+		static int sprite_stars;
 		
 		// Label for Star Selection Mode. Static because there will only ever be
 		// one of these.
@@ -59,17 +123,38 @@ class Galaxy:public LabeledDrawable
 		// How to cluster files in the galaxy.
 		cluster_type cluster_mode;
 		
+		// Where the stars were placed, for this galaxy and clustering mode.
+		// Cleared when the mode changes, until the sectors are built for it.
+		StarLayout* layout;
+		bool layout_matches;
+		
+		void init(cluster_type m, list<string>* t);
+		bool calcDimensions();
+		
 		void buildSectors();
 		void buildHierarchy();
+		void foldDirectories(list<DirNode*>* dirs, float total, int limit, list<DirNode*>* kept, list<DirNode*>* folded);
 		void buildByName();
+		void splitByName(vector<pair<string,int> >* keys, int begin, int end, size_t depth, int target, vector<int>* bounds, vector<string>* names);
+		void addNameGroup(vector<pair<string,int> >* keys, int begin, int end, size_t depth, vector<int>* bounds, vector<string>* names);
 		void buildByDate();
+		static int groupBins(vector<int>* counts, int target, vector<int>* groups);
 		void buildBySize();
 		void buildByType();
 		void buildByTags();
+		void addGroupSectors(vector<list<FileNode*>*>* groups, vector<string>* labels);
+		void addTags(list<string>* t);
 		
 		void adjustSectorWidths();
+		void resizeSectors();
 		void clearSectors();
 		
+		void openLayout();
+		void saveLayout();
+		
+		DirNode* topDirectory(FileNode* f);
+		void mapDirectories(map<DirNode*,GSector*>* m);
+		
 		void drawNormalMode();
 		void drawStarSelectionMode();
 		
@@ -77,6 +162,7 @@ class Galaxy:public LabeledDrawable
 		
 	public:
 		Galaxy(DirNode* r, list<FileNode*>* f = NULL, cluster_type m = DIRECTORY, string n = "", list<string>* t = NULL);
+		Galaxy(list<DirNode*>* d, cluster_type m, string n);
 		~Galaxy();
 		
 		void setName(string n);
@@ -87,6 +173,7 @@ class Galaxy:public LabeledDrawable
 		float getRotationX();
 		float getRotationY();
 		float getRotationSpeed();
+		bool animate(float dt);
 		
 		void setClusterMode(cluster_type m);
 		cluster_type getClusterMode();
@@ -97,11 +184,22 @@ class Galaxy:public LabeledDrawable
 		
 		void setDirectory(DirNode* r);
 		DirNode* getDirectory();
+		list<DirNode*>* getMembers();
+		void setMembers(list<DirNode*>* d);
 		void setFileList(list<FileNode*>* f);
+		void adoptFileList();
 		list<FileNode*>* getFileList();
 		
 		list<GSector*>* getSectors();
 		
+		static void setSectorLimits(int n, float a);
+		static void setClusterSectors(int n);
+		static void setSpriteStars(int n);
+		static void fitArcWidths(vector<float>* widths, vector<float>* floors, float total);
+		
+		bool applyChanges(TreeChanges* c);
+		int prefetch(int max);
+		
 		bool isColliding(float x, float y);
 		GSector* getSelected();
 		
@@ -0,0 +1,123 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			IndexSnapshot.h
+// Programmer:			Matthew Hydock
+//
+// File description:	Header for a class that saves a directory tree to a
+//						compact binary file after indexing, and maps it back
+//						into memory on the next start, so the tree doesn't have
+//						to be rebuilt.
+//==============================================================================
+
+#include "global_header.h"
+#include "DirTree.h"
+
+#include <map>
+#include <stdint.h>
+
+#ifndef INDEXSNAPSHOT
+#define INDEXSNAPSHOT
+
+#define SNAPSHOT_MAGIC "SNAVIDX"
+#define SNAPSHOT_VERSION 3
+
+// Layout of a snapshot file. The header is followed by the directory records,
+// the file records, then a block of null-terminated strings that the records
+// refer to by offset. Directories are stored breadth-first, so the children of
+// any directory are one contiguous run, and so are its files.
+struct SnapshotHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t num_dirs;
+	uint32_t num_files;
+	uint32_t root_name;
+	uint64_t dirs_offset;
+	uint64_t files_offset;
+	uint64_t strings_offset;
+	uint64_t strings_size;
+};
+
+struct SnapshotDir
+{
+	uint32_t name;
+	int32_t parent;
+	uint32_t first_dir;
+	uint32_t num_dirs;
+	uint32_t first_file;
+	uint32_t num_files;
+	int64_t mtime;
+	int64_t ctime;
+};
+
+// Only the parts of a file's metadata flagged in known (FILE_HAVE_*) were read
+// before the snapshot was saved; the rest are left to be read later.
+struct SnapshotFile
+{
+	uint32_t name;
+	uint32_t mime;
+	uint32_t tags;
+	uint32_t mode;
+	uint32_t known;
+	uint32_t unused;
+	uint64_t ino;
+	int64_t size;
+	int64_t blocks;
+	int64_t mtime;
+	int64_t ctime;
+};
+
+class IndexSnapshot;
+
+// A directory waiting to be saved: a node, or the record of a directory that
+// was never read out of a loaded snapshot.
+struct SaveItem
+{
+	DirNode* node;
+	IndexSnapshot* snapshot;
+	int index;
+};
+
+class IndexSnapshot
+{
+	private:
+		string path;
+
+		// The mapped file, and pointers to its sections.
+		void* mapping;
+		size_t map_size;
+		const SnapshotHeader* header;
+		const SnapshotDir* dirs;
+		const SnapshotFile* files;
+		const char* strings;
+
+		const char* getString(uint32_t offset);
+		bool validate();
+		void saveRecords(int index, SnapshotDir* sd, vector<SaveItem>* order, vector<SnapshotFile>* file_recs, string& block, map<string,uint32_t>& seen);
+
+	public:
+		IndexSnapshot(string p);
+		~IndexSnapshot();
+
+		bool load();
+		void unload();
+		bool isLoaded();
+
+		string getRootPath();
+		int getNumFiles();
+		int getNumDirs();
+
+		void attach(DirTree* t);
+		void expand(DirNode* d, int index);
+
+		const SnapshotDir* getDirRecord(int index);
+		string getDirName(int index);
+
+		static bool save(DirTree* t, string p);
+		static string cacheDirectory();
+		static string pathFor(string root);
+};
+
+#endif
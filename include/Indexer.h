@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		14 February 2011
-// Last Updated:		29 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			Indexer.h
 // Programmer:			Matthew Hydock
@@ -10,26 +10,77 @@
 
 #include "global_header.h"
 #include "DirTree.h"
+#include "DirWalker.h"
+#include "IndexSnapshot.h"
+#include "TreeChanges.h"
+
+#include <set>
+#include <sys/time.h>
 
 #ifndef INDEXER
 #define INDEXER
 
+// How often a build in the background hands what it has found so far over to
+// be shown, in seconds.
+#define INDEX_PUBLISH_INTERVAL 0.25
+
+// What a refresh did. Reused files were kept as they were, changed files were
+// looked at again, and added and removed count files only (a directory that
+// came or went counts as the files inside it).
+struct RefreshStats
+{
+	int reused;
+	int added;
+	int removed;
+	int changed;
+	int dirs_read;
+};
+
 class Indexer
 {
 	private:
 		DirTree* dir_tree;
+		IndexSnapshot* snapshot;
+		int num_threads;
+		
+		// The walker for a build that is running in the background, and when
+		// the build started and last handed over results.
+		DirWalker* walker;
+		struct timeval build_start;
+		double last_publish;
 		
-		void build(string dir);
+		void mergeResults(DirWalker* w, TreeChanges* changes = NULL);
+		void refreshDirectory(DirNode* d, int fd, RefreshStats* stats, vector<DirNode*>* fresh, set<DirNode*>* skip, TreeChanges* changes);
+		void refreshRecords(DirNode* anchor, vector<string>* trail, IndexSnapshot* s, int index, int fd, RefreshStats* stats, vector<DirNode*>* fresh, set<DirNode*>* skip, TreeChanges* changes);
+		void rereadDirectory(DirNode* d, int fd, RefreshStats* stats, vector<DirNode*>* fresh, set<DirNode*>* skip, TreeChanges* changes);
+		void walkNew(vector<DirNode*>* fresh, RefreshStats* stats, TreeChanges* changes);
+		void reportRefresh(RefreshStats* stats, struct timeval* start);
+		double secondsSince(struct timeval* start);
+		void finishBuild();
+		bool loadSnapshot();
+		void saveSnapshot();
 		
 	public:
-		Indexer(string root_path);
+		Indexer(string root_path, int threads = 0, bool rebuild = false, bool background = false);
 		~Indexer();
 		
 		void build();
+		void startBuild();
+		TreeChanges* collect();
+		void wait();
+		
+		bool isBuilding();
+		int getFilesFound();
+		int getDirsPending();
+		int getFilesPerSecond();
+		
+		RefreshStats refresh(TreeChanges* changes = NULL);
+		RefreshStats refreshDirectories(list<DirNode*>* dirs, TreeChanges* changes = NULL);
 		void changeRoot(string new_root);
 		void clearTree();
+		void setNumThreads(int t);
+		int getNumThreads();
 		DirTree* getDirectoryTree();
-		list<FileNode*>* getFileList();
 };
 
 #endif
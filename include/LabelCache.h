@@ -0,0 +1,59 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			LabelCache.h
+// Programmer:			Matthew Hydock
+//
+// File description:	Header for a cache of the name labels shown over stars
+//						and sectors. Labels are kept by text and font, up to a
+//						set number of bytes, and the least recently used ones
+//						are let go of first.
+//==============================================================================
+
+#include "DrawText.h"
+
+#include <map>
+
+#ifndef LABELCACHE
+#define LABELCACHE
+
+// How many bytes of labels to keep around.
+#define LABEL_CACHE_BYTES (256*1024)
+
+// The font every name label is drawn in.
+#define LABEL_FONT "/usr/share/fonts/truetype/freefont/FreeSans.ttf"
+#define LABEL_FONT_SIZE 14
+
+class LabelCache
+{
+	private:
+		// A label, what it is kept under, and how much memory it takes.
+		struct Entry
+		{
+			string key;
+			DrawText* label;
+			size_t bytes;
+		};
+
+		// Most recently used first.
+		static list<Entry> entries;
+		static map<string,list<Entry>::iterator> index;
+
+		static size_t bytes;
+		static int hits;
+		static int misses;
+
+		static DrawText* makeLabel(string text, string font, int size);
+		static void evict();
+
+	public:
+		static DrawText* get(string text, string font = LABEL_FONT, int size = LABEL_FONT_SIZE);
+
+		static size_t getBytes();
+		static int getNumLabels();
+		static int getHits();
+		static int getMisses();
+};
+
+#endif
@@ -1,24 +1,22 @@
 //==============================================================================
 // Date Created:		13 May 2011
-// Last Updated:		16 May 2011
+// Last Updated:		18 October 2026
 //
 // File name:			LabeledDrawable.h
 // Programmer:			Matthew Hydock
 //
 // File description:	Header for a special class of drawable items that have
-//						built-in name labels.
+//						built-in name labels. The labels are kept in the label
+//						cache rather than by each item.
 //==============================================================================
 
-#include "DrawText.h"
+#include "LabelCache.h"
 
 #ifndef LABELEDDRAWABLE
 #define LABELEDDRAWABLE
 
 class LabeledDrawable:public Drawable
 {
-	protected:
-		DrawText* label;
-		
 	public:
 		virtual ~LabeledDrawable() {};
 		
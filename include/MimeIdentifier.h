@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		16 February 2011
-// Last Updated:		29 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			MimeIdentifier.h
 // Programmer:			Matthew Hydock
@@ -12,6 +12,7 @@
 #include "global_header.h"
 
 #include <magic.h>
+#include <pthread.h>
 
 #ifndef MIMEIDENTIFIER
 #define MIMEIDENTIFIER
@@ -24,14 +25,46 @@ class MimeIdentifier
 	private:
 		list< vector<string> > default_apps;
 		
+		// A libmagic handle is expensive to load and can't be shared between
+		// threads, so each thread gets its own, loaded the first time it asks.
+		// When a thread exits, its handle goes back in the pool for the next
+		// thread to reuse.
+		struct Cookie
+		{
+			MimeIdentifier* owner;
+			magic_t magic;
+		};
+		
+		pthread_key_t cookie_key;
+		pthread_mutex_t pool_lock;
+		list<Cookie*> all_cookies;
+		list<Cookie*> free_cookies;
+		
+		// A slice of a batch passed to classify().
+		struct ClassifyJob
+		{
+			MimeIdentifier* owner;
+			vector<string>* paths;
+			vector<string>* types;
+			size_t begin;
+			size_t end;
+		};
+		
 		void buildDefaultAppsList();
+		magic_t getCookie();
+		
+		static void releaseCookie(void* c);
+		static void* classifyWorker(void* j);
 		
 	public:
 		MimeIdentifier();
+		~MimeIdentifier();
 		
 		string setDefaultApp(string pathname);
 		string setFileType(string mime_type);
 		enum filetype enumFileType(string mime_type);
+		
+		vector<string>* classify(vector<string>* paths, int threads = 0);
 };
 
 #endif
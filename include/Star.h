@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		14 February 2011
-// Last Updated:		13 May 2011
+// Last Updated:		18 October 2026
 //
 // File name:			Star.h
 // Programmer:			Matthew Hydock
@@ -41,14 +41,20 @@ class Star:public LabeledDrawable
 		void setDepth(float d);
 		
 		string getName();
+		FileNode* getFile();
 		float getRadius();
 		float getDiameter();
 		float getDistance();
 		float getAngle();
 		float getDepth();
+		float* getColor();
+		
+		static TextureObject* getTexture();
 		
 		void setPosition(float a, float dis, float dep);
-		void randomPosition(float a1, float a2, float dis1, float dis2, float dep1, float dep2);
+		void randomPosition(MTRand* r, float a1, float a2, float dis1, float dis2, float dep1, float dep2);
+		
+		static void randomPositions(MTRand* r, int n, float a1, float a2, float dis1, float dis2, float dep1, float dep2, float* a, float* dis, float* dep);
 		void recalc();
 		
 		void activate();
@@ -56,6 +62,7 @@ class Star:public LabeledDrawable
 		
 		static void setTexturedDrawMode();
 		static void setPointDrawMode();
+		static bool isTexturedDrawMode();
 		
 		void draw();
 		void drawTextured();
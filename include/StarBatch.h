@@ -0,0 +1,90 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			StarBatch.h
+// Programmer:			Matthew Hydock
+//
+// File description:	Header for a class that draws every star in a galaxy at
+//						once. The stars' quads are packed into one vertex array,
+//						kept in a vertex buffer when the GL has them, and only
+//						packed again when the stars change. Very large galaxies
+//						are packed as one point per star instead, and drawn as
+//						point sprites.
+//==============================================================================
+
+#include "GSector.h"
+
+#include <vector>
+
+#ifndef STARBATCH
+#define STARBATCH
+
+// One corner of a star's quad, laid out the way glInterleavedArrays expects
+// for GL_T2F_C4UB_V3F.
+struct StarVertex
+{
+	GLfloat s, t;
+	GLubyte color[4];
+	GLfloat x, y, z;
+};
+
+// A star drawn as a point sprite, laid out for GL_C4UB_V3F.
+struct StarPoint
+{
+	GLubyte color[4];
+	GLfloat x, y, z;
+};
+
+// How finely point sprite sizes are told apart, in galaxy units. Stars are
+// grouped by size, and each group is drawn with one glPointSize.
+#define STARBATCH_SIZE_STEP 0.25
+
+class StarBatch
+{
+	private:
+		vector<StarVertex> vertices;
+
+		// The points, sorted by size, and the runs of points that share a
+		// size: their diameter and how many there are.
+		vector<StarPoint> points;
+		vector<pair<float,int> > runs;
+
+		// Whether the batch is packed as point sprites.
+		bool sprites;
+
+		// The sectors the vertices were packed from, in order. If the galaxy's
+		// sectors no longer match, the batch is packed again.
+		vector<GSector*> packed;
+
+		// The vertex buffer, once it has been made. Without vertex buffers
+		// (before OpenGL 1.5) the vertices are drawn from memory instead.
+		// Without point sprites (before OpenGL 2.0) points are drawn as
+		// plain round points.
+		GLuint vbo;
+		bool checked;
+		bool use_vbo;
+		bool use_point_sprites;
+
+		bool needsPacking(list<GSector*>* sectors);
+		void pack(list<GSector*>* sectors);
+		void packPoints(list<GSector*>* sectors);
+		void addStar(Star* s);
+		void upload();
+
+		void drawQuads();
+		void drawPoints(float scale);
+
+		static bool hasVersion(int major, int minor);
+
+	public:
+		StarBatch();
+		~StarBatch();
+
+		bool update(list<GSector*>* sectors);
+		int getNumStars();
+
+		void draw(float scale);
+};
+
+#endif
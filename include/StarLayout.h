@@ -0,0 +1,76 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			StarLayout.h
+// Programmer:			Matthew Hydock
+//
+// File description:	Header for a class that remembers where each star in a
+//						galaxy was placed, and keeps it on disk, so a galaxy
+//						that is built again looks the same as it did last time.
+//==============================================================================
+
+#include "global_header.h"
+#include "FileNode.h"
+
+#include <stdint.h>
+#include <tr1/unordered_map>
+
+#ifndef STARLAYOUT
+#define STARLAYOUT
+
+#define LAYOUT_MAGIC "SNAVLAY"
+#define LAYOUT_VERSION 2
+
+// Layout of a layout file: the header, followed by one record per star.
+struct LayoutHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t num_stars;
+};
+
+// The angle is a fraction of the way across the sector's arc, and the distance
+// and depth are fractions of its radius and thickness, so the positions still
+// fit after the sector has been widened, moved, grown, or shrunk.
+struct LayoutStar
+{
+	uint64_t key;
+	float angle;
+	float distance;
+	float depth;
+	uint32_t unused;
+};
+
+class StarLayout
+{
+	private:
+		// Where a star was, and whether it has been recorded since the
+		// layout was loaded. Stars that weren't are dropped when saving.
+		struct StarPlace
+		{
+			float angle;
+			float distance;
+			float depth;
+			bool seen;
+		};
+
+		string path;
+		tr1::unordered_map<uint64_t,StarPlace> places;
+		bool changed;
+
+	public:
+		StarLayout(string p);
+
+		bool load();
+		bool save();
+
+		bool find(FileNode* f, float* a, float* dis, float* dep);
+		void record(FileNode* f, float a, float dis, float dep);
+		int getNumStars();
+
+		static uint64_t keyFor(FileNode* f);
+		static string pathFor(string root, int mode);
+};
+
+#endif
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		6 April 2011
-// Last Updated:		17 May 2011
+// Last Updated:		18 October 2026
 //
 // File name:			StateManager.h
 // Programmer:			Matthew Hydock
@@ -12,22 +12,34 @@
 //==============================================================================
 
 #include "Indexer.h"
+#include "TreeWatcher.h"
 #include "Galaxy.h"
 
 #ifndef STATEMANAGER
 #define STATEMANAGER
 
+// How many files' metadata to read for the current galaxy each time update()
+// has nothing else to do.
+#define PREFETCH_BATCH 64
+
 class StateManager:public Drawable
 {
 	private:
 		Indexer* indexer;
+		TreeWatcher* watcher;
 		list<Galaxy*> galaxies;
 		list<Galaxy*>::iterator curr;
 		
 		list<string>* tags;
+		
+		void showClustered(cluster_type m);
+		
+		// Counts how many times the galaxies have been patched, so anything
+		// showing them knows when to look again.
+		int revision;
 	
 	public:
-		StateManager(string dir);
+		StateManager(string dir, int threads = 0, bool rebuild = false);
 		~StateManager();
 		
 		Galaxy* getCurrent();
@@ -39,6 +51,11 @@ class StateManager:public Drawable
 		void setActiveTags(list<string>* t);
 		void deleteFuture();
 		
+		bool update();
+		bool animate(float dt);
+		int getRevision();
+		Indexer* getIndexer();
+		
 		void setDirectoryMode();
 		void setNameMode();
 		void setDateMode();
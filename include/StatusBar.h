@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		6 May 2011
-// Last Updated:		13 May 2011
+// Last Updated:		18 October 2026
 //
 // File name:			StatusBar.h
 // Programmer:			Matthew Hydock
@@ -21,6 +21,7 @@ class StatusBar:public Drawable
 	private:
 		StateManager* state;
 		Galaxy* curr;
+		int revision;
 		DrawText* directory;
 		DrawText* num_files;
 		
@@ -0,0 +1,118 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			TreeArena.h
+// Programmer:			Matthew Hydock
+//
+// File description:	Header for a flat store of the directory tree's metadata.
+//						Every file's name and attributes are kept in columns,
+//						one row per file, with each FileNode a view of its row.
+//						Once laid out, rows are in preorder, so every subtree's
+//						files are one contiguous run of rows, and directories
+//						are rows of their own with their parent, first child,
+//						and next sibling as row numbers.
+//==============================================================================
+
+#include "global_header.h"
+#include "MimeIdentifier.h"
+
+#include <map>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#ifndef TREEARENA
+#define TREEARENA
+
+// Mime-types are numbered to fit a 16 bit column. Once all but the last number
+// are used, every new type is given that one, which stands for a type that
+// couldn't be told apart.
+#define ARENA_MAX_MIMES 65536
+#define ARENA_OVERFLOW_MIME "unknown"
+
+class FileNode;
+class DirNode;
+
+class TreeArena
+{
+	friend class FileNode;
+	friend class DirNode;
+
+	private:
+		// The file columns. Rows of files that have gone are reused by new
+		// files until the arena is next laid out. Names are kept end to end
+		// in one block, null-terminated, and found by their offsets.
+		vector<FileNode*> view;
+		vector<uint32_t> name;
+		vector<ino_t> ino;
+		vector<off_t> size;
+		vector<blkcnt_t> blocks;
+		vector<time_t> mtime;
+		vector<time_t> ctime;
+		vector<mode_t> mode;
+		vector<uint16_t> mime;
+		vector<unsigned char> known;
+
+		vector<char> names;
+		vector<int> free_rows;
+		int live;
+
+		// The directory columns, in preorder, as of the last layout. A
+		// directory's own files run from dir_files to dir_files_end, and its
+		// whole subtree's up to dir_subtree_end. They are only right while
+		// laid_out is set; any change to the shape of the tree clears it.
+		vector<DirNode*> dir_view;
+		vector<int> dir_parent;
+		vector<int> dir_first_child;
+		vector<int> dir_next_sibling;
+		vector<int> dir_files;
+		vector<int> dir_files_end;
+		vector<int> dir_subtree_end;
+		bool laid_out;
+
+		// Every distinct mime-type is stored once, with its default app and
+		// kind, and files refer to it by number. Number zero is no type.
+		struct MimeType
+		{
+			const string* type;
+			string app;
+			unsigned char kind;
+		};
+
+		vector<MimeType> mimes;
+		map<string,int> mime_numbers;
+
+		int allocate(FileNode* f, string n);
+		void release(int r);
+		uint32_t addName(string n);
+		void setName(int r, string n);
+		const char* nameAt(int r);
+		int findMime(string type);
+		int addMime(string type, string app, enum filetype kind);
+
+		int layDirectory(DirNode* d, int parent, vector<int>* order);
+
+	public:
+		TreeArena();
+
+		void layOut(DirNode* root);
+		void touch();
+		bool isLaidOut(DirNode* d);
+		int getNumLive();
+
+		bool getRange(DirNode* d, int* begin, int* end);
+		FileNode* getFile(int r);
+		off_t getSize(int r);
+		blkcnt_t getBlocks(int r);
+		time_t getModifiedTime(int r);
+		enum filetype getMimeEnum(int r);
+		int getKnown(int r);
+
+		int getDirRow(DirNode* d);
+		DirNode* getDirectory(int dr);
+		int getParentRow(int dr);
+		int getFirstChildRow(int dr);
+		int getNextSiblingRow(int dr);
+};
+
+#endif
@@ -0,0 +1,59 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			TreeChanges.h
+// Programmer:			Matthew Hydock
+//
+// File description:	Header for a class that records what changed in a
+//						directory tree during one refresh, so the galaxies that
+//						are showing the tree can be patched to match.
+//==============================================================================
+
+#include "global_header.h"
+#include "DirNode.h"
+
+#include <set>
+
+#ifndef TREECHANGES
+#define TREECHANGES
+
+class TreeChanges
+{
+	private:
+		list<FileNode*> added;
+		list<FileNode*> changed;
+		set<FileNode*> removed;
+		list<DirNode*> added_dirs;
+		set<DirNode*> removed_dirs;
+
+		// Nodes that have been taken out of the tree. They are only deleted
+		// along with the change set, so anything still pointing at them can
+		// let go first.
+		list<FileNode*> detached_files;
+		list<DirNode*> detached_dirs;
+
+		void collectRemoved(DirNode* d);
+
+	public:
+		TreeChanges();
+		~TreeChanges();
+
+		void addFile(FileNode* f);
+		void changeFile(FileNode* f);
+		void removeFile(FileNode* f);
+		void addDirectory(DirNode* d);
+		void removeDirectory(DirNode* d);
+
+		list<FileNode*>* getAdded();
+		list<FileNode*>* getChanged();
+		set<FileNode*>* getRemoved();
+		list<DirNode*>* getAddedDirectories();
+		set<DirNode*>* getRemovedDirectories();
+
+		bool isRemoved(FileNode* f);
+		bool isRemoved(DirNode* d);
+		bool isEmpty();
+};
+
+#endif
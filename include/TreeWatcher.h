@@ -0,0 +1,84 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			TreeWatcher.h
+// Programmer:			Matthew Hydock
+//
+// File description:	Header for a class that watches an indexed directory
+//						tree with inotify, and keeps the tree in step with the
+//						file system. Bursts of events are gathered up, and the
+//						directories they touched are read again in one go.
+//==============================================================================
+
+#include "global_header.h"
+#include "Indexer.h"
+#include "TreeChanges.h"
+
+#include <map>
+#include <set>
+#include <sys/inotify.h>
+
+#ifndef TREEWATCHER
+#define TREEWATCHER
+
+// Events to listen for on each directory.
+#define WATCH_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ATTRIB | IN_ONLYDIR | IN_DONT_FOLLOW)
+
+// How long things must be quiet before the changed directories are read, and
+// the longest any change is held back while events keep coming, in seconds.
+#define WATCH_SETTLE 0.25
+#define WATCH_MAX_DELAY 2.0
+
+// How often the whole tree is checked when inotify can't be used for all of
+// it, in seconds.
+#define WATCH_POLL_INTERVAL 30.0
+
+class TreeWatcher
+{
+	private:
+		Indexer* indexer;
+		int fd;
+
+		map<int,DirNode*> watches;
+		map<DirNode*,int> descriptors;
+
+		// Directories still waiting in the index snapshot are watched by their
+		// paths, so no nodes have to be made for them. The first event in one
+		// reads out just the directories on the way to it.
+		map<int,string> record_watches;
+
+		// Directories with events waiting on them, and when the first and
+		// latest of those events came in. If events were lost, the whole tree
+		// has to be checked instead.
+		set<DirNode*> dirty;
+		double first_event;
+		double last_event;
+		bool overflowed;
+
+		// Set when inotify couldn't watch every directory, after which the
+		// whole tree is checked every so often as well.
+		bool polling;
+		double last_poll;
+
+		void watchTree(DirNode* d);
+		void watchRecords(IndexSnapshot* s, int index, string path);
+		void watchDirectory(DirNode* d);
+		int addWatch(string path);
+		DirNode* resolve(int wd);
+		void forget(DirNode* d);
+		void markDirty(DirNode* d);
+		void readEvents();
+
+	public:
+		TreeWatcher(Indexer* ix);
+		~TreeWatcher();
+
+		bool isWatching();
+		bool isPolling();
+		int getNumWatches();
+
+		TreeChanges* poll();
+};
+
+#endif
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		6 February 2011
-// Last Updated:		17 April 2011
+// Last Updated:		18 October 2026
 //
 // File name:			global_header.h
 // Programmer:			Matthew Hydock
@@ -18,6 +18,7 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
 #include <math.h>
 #include <time.h>
@@ -69,6 +70,19 @@ extern inline bool isLessThan(string s1, string s2)
 	return diff < 0;
 }
 
+extern inline int compareNames(const string& s1, const string& s2)
+// Compares two names without regard to case, like isLessThan(), but falls back
+// on a case-sensitive comparison so that no two different names are equal.
+// Returns less than, equal to, or greater than zero, like strcmp().
+{
+	int diff = strcasecmp(s1.c_str(),s2.c_str());
+
+	if (diff == 0)
+		diff = s1.compare(s2);
+
+	return diff;
+}
+
 extern inline list<string>* tokenizeL(string s, string del)
 {
 	if (s.compare("") == 0)
@@ -114,6 +128,36 @@ extern inline vector<string>* tokenizeV(string s, string del)
 	return v;
 }
 
+extern inline unsigned long hashString(const string& s)
+// Hash a string into 32 bits (FNV-1a), for seeding random number generators so
+// that the same string always gives the same numbers.
+{
+	unsigned long h = 2166136261UL;
+	
+	for (size_t i = 0; i < s.size(); i++)
+	{
+		h ^= (unsigned char)s[i];
+		h = (h * 16777619UL) & 0xffffffffUL;
+	}
+	
+	return h;
+}
+
+extern inline unsigned long long hashString64(const string& s)
+// Hash a string into 64 bits (FNV-1a), for naming things by their paths where
+// 32 bits would give too many collisions.
+{
+	unsigned long long h = 14695981039346656037ULL;
+	
+	for (size_t i = 0; i < s.size(); i++)
+	{
+		h ^= (unsigned char)s[i];
+		h *= 1099511628211ULL;
+	}
+	
+	return h;
+}
+
 template<typename T> extern inline void append(list<T>* l1, list<T>* l2)
 // Since the list library doesn't have a function to append a list onto another
 // list...
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		28 March 2012
-// Last Updated:		29 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			DirNode.cpp
 // Programmer:			Matthew Hydock
@@ -8,15 +8,29 @@
 // File description:	Implementation of a class that contains data for a
 //						directory. The directory has full knowledge of its
 //						contents (files and sub-directories) and its parent.
+//						Contents are kept in name order, and indexed by name.
+//						Totals for the whole of each directory's subtree are
+//						kept up to date as the tree changes.
 //==============================================================================
 
 #include "DirNode.h"
+#include "IndexSnapshot.h"
 
 DirNode::DirNode(DirNode* p, string n)
 // Creates a new DirNode, giving it a name and setting its parent.
 {
 	name = n;
 	parent = p;
+	
+	mtime = 0;
+	ctime = 0;
+	
+	snapshot = NULL;
+	snapshot_index = 0;
+	
+	memset(&totals,0,sizeof(totals));
+	attached = false;
+	row = -1;
 }
 
 DirNode::~DirNode()
@@ -37,25 +51,56 @@ DirNode::~DirNode()
 		delete *dli;
 		
 	dirs.clear();
+	
+	file_index.clear();
+	dir_index.clear();
+	
+	FileNode::arena->touch();
 }
 
 //==============================================================================
 // Methods to locate files or directories in this directory.
 //==============================================================================
+void DirNode::expand()
+// If this directory's contents are still in a snapshot, read them out.
+{
+	if (snapshot == NULL)
+		return;
+	
+	// Clear the snapshot first, as the snapshot adds the contents through the
+	// usual methods, which call this again.
+	IndexSnapshot* s = snapshot;
+	snapshot = NULL;
+	
+	s->expand(this,snapshot_index);
+	
+	// Everything read out of the snapshot is in the totals now.
+	DirTotals t;
+	memset(&t,0,sizeof(t));
+	t.unread = 1;
+	adjustTotals(NULL,&t);
+}
+
 list<FileNode*>::iterator DirNode::findFile(string fn)
 // Tries to find a file, given the name of the file.
 {
-	list<FileNode*>::iterator fli = files.begin();
-	for (; fli != files.end() && ((*fli)->getName().compare(fn) != 0); fli++);
+	expand();
 	
-	return fli;
+	tr1::unordered_map<string,list<FileNode*>::iterator>::iterator i = file_index.find(fn);
+	
+	if (i == file_index.end())
+		return files.end();
+	
+	return i->second;
 }
 
 list<FileNode*>::iterator DirNode::findFile(FileNode* f)
 // Tries to find a reference to the given file in this directory.
-{	
-	list<FileNode*>::iterator fli = files.begin();
-	for (; fli != files.end() && (*fli != f); fli++);
+{
+	list<FileNode*>::iterator fli = findFile(f->getName());
+	
+	if (fli != files.end() && *fli != f)
+		return files.end();
 	
 	return fli;
 }
@@ -63,20 +108,171 @@ list<FileNode*>::iterator DirNode::findFile(FileNode* f)
 list<DirNode*>::iterator DirNode::findDirectory(string dn)
 // Tries to find a sub-directory, given the name of the sub-directory.
 {
-	list<DirNode*>::iterator dli = dirs.begin();
-	for (; dli != dirs.end() && ((*dli)->getName().compare(dn) != 0); dli++);
+	expand();
 	
-	return dli;
+	tr1::unordered_map<string,list<DirNode*>::iterator>::iterator i = dir_index.find(dn);
+	
+	if (i == dir_index.end())
+		return dirs.end();
+	
+	return i->second;
 }
 
 list<DirNode*>::iterator DirNode::findDirectory(DirNode* d)
 // Tries to find a reference to the given sub-directory in this directory.
 {
-	list<DirNode*>::iterator dli = dirs.begin();
-	for (; dli != dirs.end() && (*dli != d); dli++);
+	list<DirNode*>::iterator dli = findDirectory(d->getName());
+	
+	if (dli != dirs.end() && *dli != d)
+		return dirs.end();
 	
 	return dli;
 }
+
+void DirNode::insertFile(FileNode* f)
+// Put a file into the list in name order, and index it. The list is searched
+// from the back, so files that are added in order go straight on the end.
+{
+	string fn = f->getName();
+	list<FileNode*>::iterator fli = files.end();
+	
+	while (fli != files.begin())
+	{
+		list<FileNode*>::iterator prev = fli;
+		prev--;
+		
+		if (compareNames((*prev)->getName(),fn) <= 0)
+			break;
+		
+		fli = prev;
+	}
+	
+	file_index[fn] = files.insert(fli,f);
+	FileNode::arena->touch();
+	
+	DirTotals t;
+	fileTotals(f,&t);
+	adjustTotals(&t,NULL);
+	FileNode::arena->known[f->row] |= FILE_COUNTED;
+}
+
+void DirNode::insertDirectory(DirNode* d)
+// Put a sub-directory into the list in name order, and index it. The list is
+// searched from the back, so directories that are added in order go straight
+// on the end.
+{
+	string dn = d->getName();
+	list<DirNode*>::iterator dli = dirs.end();
+	
+	while (dli != dirs.begin())
+	{
+		list<DirNode*>::iterator prev = dli;
+		prev--;
+		
+		if (compareNames((*prev)->getName(),dn) <= 0)
+			break;
+		
+		dli = prev;
+	}
+	
+	d->place = dirs.insert(dli,d);
+	dir_index[dn] = d->place;
+	FileNode::arena->touch();
+	
+	DirTotals t = d->totals;
+	t.dirs++;
+	adjustTotals(&t,NULL);
+	d->attached = true;
+}
+
+void DirNode::fileTotals(FileNode* f, DirTotals* t)
+// Work out a single file's share of the totals, from its row of the arena.
+{
+	TreeArena* a = FileNode::arena;
+	int r = f->row;
+	
+	memset(t,0,sizeof(DirTotals));
+	
+	t->files = 1;
+	t->bytes = a->size[r];
+	t->blocks = a->blocks[r];
+	t->newest = a->mtime[r];
+	t->types[a->getMimeEnum(r)] = 1;
+	t->missing_attrs = (a->known[r] & FILE_HAVE_ATTR) ? 0 : 1;
+}
+
+void DirNode::adjustTotals(DirTotals* add, DirTotals* sub)
+// Add one set of totals to this directory and every directory above it, and
+// take another away. Either can be NULL. The newest time can't be taken away,
+// so if what was taken away might have been the newest, it is found again
+// from each directory's own files and the sub-directories' newest times.
+{
+	time_t add_newest = (add == NULL) ? 0 : add->newest;
+	time_t sub_newest = (sub == NULL) ? 0 : sub->newest;
+	
+	for (DirNode* n = this; n != NULL; n = n->attached ? n->parent : NULL)
+	{
+		DirTotals* t = &n->totals;
+		
+		if (add != NULL)
+		{
+			t->files += add->files;
+			t->dirs += add->dirs;
+			t->bytes += add->bytes;
+			t->blocks += add->blocks;
+			t->unread += add->unread;
+			t->missing_attrs += add->missing_attrs;
+			for (int i = 0; i <= UNKNOWN; i++)
+				t->types[i] += add->types[i];
+		}
+		
+		if (sub != NULL)
+		{
+			t->files -= sub->files;
+			t->dirs -= sub->dirs;
+			t->bytes -= sub->bytes;
+			t->blocks -= sub->blocks;
+			t->unread -= sub->unread;
+			t->missing_attrs -= sub->missing_attrs;
+			for (int i = 0; i <= UNKNOWN; i++)
+				t->types[i] -= sub->types[i];
+		}
+		
+		if (sub_newest > add_newest && sub_newest >= t->newest)
+			n->findNewest();
+		else if (add_newest > t->newest)
+			t->newest = add_newest;
+	}
+}
+
+void DirNode::findNewest()
+// Find the newest time in this directory's subtree from scratch, using the
+// sub-directories' totals.
+{
+	time_t newest = 0;
+	
+	vector<time_t>* m = &FileNode::arena->mtime;
+	
+	for (list<FileNode*>::iterator i = files.begin(); i != files.end(); i++)
+		if ((*m)[(*i)->row] > newest)
+			newest = (*m)[(*i)->row];
+	
+	for (list<DirNode*>::iterator i = dirs.begin(); i != dirs.end(); i++)
+		if ((*i)->totals.newest > newest)
+			newest = (*i)->totals.newest;
+	
+	totals.newest = newest;
+}
+
+void DirNode::expandAll()
+// Read everything below this directory out of the snapshot.
+{
+	expand();
+	
+	for (list<DirNode*>::iterator i = dirs.begin(); i != dirs.end(); i++)
+		if ((*i)->totals.unread > 0)
+			(*i)->expandAll();
+}
 //==============================================================================
 
 //==============================================================================
@@ -89,19 +285,20 @@ void DirNode::addFile(string fn)
 	list<FileNode*>::iterator fli = findFile(fn);
 		
 	if (fli == files.end())
-		files.push_back(new FileNode(this,fn));
+		insertFile(new FileNode(this,fn));
 	else
 		cout << "WARNING: A file with the name " << fn << " is already in this directory." << endl;
 }
 	
 void DirNode::addFile(FileNode* f)
-// Adds a file that already exists to this directory. If the file is already in
-// this directory, a warning is printed and nothing is added.
+// Adds a file that already exists to this directory. If the file, or another
+// with the same name, is already in this directory, a warning is printed and
+// nothing is added.
 {
-	list<FileNode*>::iterator fli = findFile(f);
+	list<FileNode*>::iterator fli = findFile(f->getName());
 		
 	if (fli == files.end())
-		files.push_back(f);
+		insertFile(f);
 	else
 		cout << "WARNING: The file " << f->getName() << " is already in this directory." << endl;
 }
@@ -116,8 +313,17 @@ FileNode* DirNode::removeFile(string fn)
 		
 	if (fli != files.end())
 	{
-		files.remove(*fli);
-		return *fli;
+		FileNode* temp = *fli;
+		file_index.erase(fn);
+		files.erase(fli);
+		FileNode::arena->touch();
+		
+		DirTotals t;
+		fileTotals(temp,&t);
+		FileNode::arena->known[temp->row] &= ~FILE_COUNTED;
+		adjustTotals(NULL,&t);
+		
+		return temp;
 	}
 	else
 	{
@@ -136,8 +342,17 @@ FileNode* DirNode::removeFile(FileNode* f)
 		
 	if (fli != files.end())
 	{
-		files.remove(*fli);
-		return *fli;
+		FileNode* temp = *fli;
+		file_index.erase(temp->getName());
+		files.erase(fli);
+		FileNode::arena->touch();
+		
+		DirTotals t;
+		fileTotals(temp,&t);
+		FileNode::arena->known[temp->row] &= ~FILE_COUNTED;
+		adjustTotals(NULL,&t);
+		
+		return temp;
 	}
 	else
 	{
@@ -178,20 +393,20 @@ void DirNode::addDirectory(string dn)
 	list<DirNode*>::iterator dli = findDirectory(dn);
 		
 	if (dli == dirs.end())
-		dirs.push_back(new DirNode(this,dn));
+		insertDirectory(new DirNode(this,dn));
 	else
 		cout << "WARNING: A directory with the name " << dn << " is already in this directory." << endl;
 }
 	
 void DirNode::addDirectory(DirNode* d)
 // Adds a sub-directory that already exists to this directory. If the sub-
-// directory is already in this directory, print a warning, and don't add
-// anything.
+// directory, or another with the same name, is already in this directory,
+// print a warning, and don't add anything.
 {
-	list<DirNode*>::iterator dli = findDirectory(d);
+	list<DirNode*>::iterator dli = findDirectory(d->getName());
 		
 	if (dli == dirs.end())
-		dirs.push_back(d);
+		insertDirectory(d);
 	else
 		cout << "WARNING: The sub-directory " << d->getName() << " is already in this directory." << endl;
 }
@@ -207,8 +422,17 @@ DirNode* DirNode::removeDirectory(string dn)
 		
 	if (dli != dirs.end())
 	{
-		dirs.remove(*dli);
-		return *dli;
+		DirNode* temp = *dli;
+		dir_index.erase(dn);
+		dirs.erase(dli);
+		FileNode::arena->touch();
+		
+		DirTotals t = temp->totals;
+		t.dirs++;
+		temp->attached = false;
+		adjustTotals(NULL,&t);
+		
+		return temp;
 	}
 	else
 	{
@@ -228,8 +452,17 @@ DirNode* DirNode::removeDirectory(DirNode* d)
 		
 	if (dli != dirs.end())
 	{
-		dirs.remove(*dli);
-		return *dli;
+		DirNode* temp = *dli;
+		dir_index.erase(temp->getName());
+		dirs.erase(dli);
+		FileNode::arena->touch();
+		
+		DirTotals t = temp->totals;
+		t.dirs++;
+		temp->attached = false;
+		adjustTotals(NULL,&t);
+		
+		return temp;
 	}
 	else
 	{
@@ -263,15 +496,41 @@ void DirNode::deleteDirectory(DirNode* d)
 //==============================================================================
 // Simple getters and setters.
 //==============================================================================
+FileNode* DirNode::getFile(string fn)
+// Returns the file with the given name, or NULL if there isn't one.
+{
+	list<FileNode*>::iterator fli = findFile(fn);
+	
+	if (fli == files.end())
+		return NULL;
+	
+	return *fli;
+}
+
+DirNode* DirNode::getDirectory(string dn)
+// Returns the sub-directory with the given name, or NULL if there isn't one.
+{
+	list<DirNode*>::iterator dli = findDirectory(dn);
+	
+	if (dli == dirs.end())
+		return NULL;
+	
+	return *dli;
+}
+
 list<FileNode*>* DirNode::getFiles()
 // Returns a reference to this directory's file list.
 {
+	expand();
+	
 	return &files;
 }
 
 list<DirNode*>* DirNode::getDirectories()
 // Returns a reference to this directory's list of sub-directories.
 {
+	expand();
+	
 	return &dirs;
 }
 		
@@ -282,9 +541,17 @@ string DirNode::getName()
 }
 
 void DirNode::rename(string n)
-// Changes the name of this directory.
+// Changes the name of this directory. It is taken out of its parent and put
+// back, so the parent's index and order stay right.
 {
+	if (parent == NULL || parent->removeDirectory(this) == NULL)
+	{
+		name = n;
+		return;
+	}
+	
 	name = n;
+	parent->addDirectory(this);
 }
 
 DirNode* DirNode::getParent()
@@ -298,6 +565,75 @@ void DirNode::setParent(DirNode* p)
 {
 	parent = p;
 }
+
+void DirNode::setTimes(time_t m, time_t c)
+// Record the modification and status change times of this directory, as of
+// the last time it was read.
+{
+	mtime = m;
+	ctime = c;
+}
+
+time_t DirNode::getModifiedTime()
+{
+	return mtime;
+}
+
+time_t DirNode::getChangedTime()
+{
+	return ctime;
+}
+
+void DirNode::setSnapshot(IndexSnapshot* s, int i)
+// Mark this directory as unread, with its contents waiting in the given
+// snapshot at index i.
+{
+	snapshot = s;
+	snapshot_index = i;
+	
+	DirTotals t;
+	memset(&t,0,sizeof(t));
+	t.unread = 1;
+	adjustTotals(&t,NULL);
+}
+
+IndexSnapshot* DirNode::getSnapshot()
+// Get the snapshot this directory's contents are still waiting in, or NULL if
+// they have been read out (or never were in one).
+{
+	return snapshot;
+}
+
+int DirNode::getSnapshotIndex()
+{
+	return snapshot_index;
+}
+
+DirTotals* DirNode::getTotals()
+// Get the totals for this directory and everything below it. If any of it is
+// still in a snapshot, it is read out first, which only ever happens once.
+{
+	if (totals.unread > 0)
+		expandAll();
+	
+	return &totals;
+}
+
+void DirNode::fileChanging(FileNode* f)
+// A file in this directory is about to change; hold onto its share of the
+// totals as they are now.
+{
+	fileTotals(f,&changing);
+}
+
+void DirNode::fileChanged(FileNode* f)
+// A file in this directory has changed; swap its old share of the totals for
+// its new one.
+{
+	DirTotals t;
+	fileTotals(f,&t);
+	adjustTotals(&t,&changing);
+}
 //==============================================================================
 
 
@@ -313,23 +649,122 @@ string DirNode::getPath()
 		
 	return parent->getPath() + name + "/";
 }
+//==============================================================================
+
 
+//==============================================================================
+// Walking every file below a directory.
+//==============================================================================
+FileIterator::FileIterator(DirNode* d)
+// Start at the first file in the given directory, or below it. If the whole
+// subtree has been read, and is laid out in the arena, its files are walked
+// as one run of rows. If the arena is out of date, but the subtree holds at
+// least half of the files, it is laid out again first, as that pays for
+// itself in one walk.
+{
+	top = d;
+	dir = d;
+	row = -1;
+	end = -1;
+	
+	TreeArena* a = FileNode::getArena();
+	
+	if (d->totals.unread == 0)
+	{
+		if (!a->isLaidOut(d) && 2*d->totals.files >= a->getNumLive())
+		{
+			DirNode* root = d;
+			while (root->attached)
+				root = root->parent;
+			
+			a->layOut(root);
+		}
 		
-list<FileNode*>* DirNode::getAllFiles()
-// Generate and return a list of all files in this directory and all descendent
-// directories.
+		if (a->getRange(d,&row,&end))
+		{
+			if (row == end)
+				dir = NULL;
+			
+			return;
+		}
+		
+		row = -1;
+	}
+	
+	file = d->getFiles()->begin();
+	
+	settle();
+}
+
+void FileIterator::nextDirectory()
+// Move on to the next directory: the first sub-directory if there is one,
+// otherwise the next directory after this one, or after the nearest parent
+// that has one. Once back at the top, the walk is over.
 {
-	if (dirs.empty())
-		return getFiles();
+	list<DirNode*>* sub = dir->getDirectories();
 	
-	list<FileNode*>* f = new list<FileNode*>;
+	if (!sub->empty())
+	{
+		dir = sub->front();
+		return;
+	}
 	
-	append(f,getFiles());
+	while (dir != top)
+	{
+		list<DirNode*>::iterator next = dir->place;
+		next++;
+		
+		if (next != dir->parent->dirs.end())
+		{
+			dir = *next;
+			return;
+		}
+		
+		dir = dir->parent;
+	}
 	
-	list<DirNode*>::iterator dli = dirs.begin();
-	for (; dli != dirs.end(); dli++)
-		append(f,(*dli)->getAllFiles());
+	dir = NULL;
+}
+
+void FileIterator::settle()
+// If the current directory has run out of files, move on until one that has
+// some is found.
+{
+	while (dir != NULL && file == dir->files.end())
+	{
+		nextDirectory();
+		
+		if (dir != NULL)
+			file = dir->getFiles()->begin();
+	}
+}
+
+bool FileIterator::done()
+{
+	return dir == NULL;
+}
+
+FileNode* FileIterator::operator*()
+{
+	if (row >= 0)
+		return FileNode::getArena()->getFile(row);
+	
+	return *file;
+}
+
+FileIterator& FileIterator::operator++()
+{
+	if (row >= 0)
+	{
+		if (++row == end)
+			dir = NULL;
+		
+		return *this;
+	}
+	
+	file++;
+	settle();
 	
-	return f;
+	return *this;
 }
 //==============================================================================
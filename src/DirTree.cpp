@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		5 March 2011
-// Last Updated:		29 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			DirTree.cpp
 // Programmer:			Matthew Hydock
@@ -57,46 +57,10 @@ DirTree::~DirTree()
 // Node-based methods
 //==============================================================================
 void DirTree::add(string p, string n)
-// Method to insert a file into its appropriate place in the file list.
-{	
-	// Tokenize the given path, and store in a vector.
-	vector<string>* path_toks = tokenizeV(p.substr(root->getName().size()),"/");
-	string dir_path = root->getName();
-	
-	// Set the current node to the root of the directory tree, and start an
-	// iterator on the current node's directory list. Also, save a reference to
-	// the current directory's sub-directory list, for convenience.
-	DirNode* curr = root;
-	list<DirNode*>* dirs = curr->getDirectories();
-	list<DirNode*>::iterator d = dirs->begin();
-	
-	// While there are still more paths to navigate...
-	for (size_t i = 0; path_toks != NULL && i < path_toks->size();)
-	{		
-		// Scan the directory list for the current sub-directory.
-		for (;d != dirs->end() && path_toks->at(i).compare((*d)->getName()) != 0 && !isLessThan(path_toks->at(i),(*d)->getName());d++);
-		
-		// If current sub-directory exists, go to it.
-		if (d != dirs->end() && path_toks->at(i).compare((*d)->getName()) == 0)
-		{
-			curr = *d;
-			dirs = curr->getDirectories();
-			d = dirs->begin();
-			i++;
-		}
-		// If current sub-directory does not exist, make it. Insertion is done
-		// directly to the directory list, instead of using the DirNode's
-		// addDirectory() method, so that the new sub-directory is in the right
-		// order in the list.
-		else
-		{
-			//cout << "creating a new directory named " << path_toks->at(i) << " in directory " << curr->getName() << endl;
-			DirNode* tempd = new DirNode(curr,path_toks->at(i));
-			//cout << "created new directory " << tempd->getName() << " in directory " << tempd->getParent()->getName() << endl;
-			dirs->insert(d,tempd);
-			d--;
-		}
-	}
+// Method to insert a file into its appropriate place in the file list. Any
+// directories on the way that don't exist yet are made.
+{
+	DirNode* curr = findDir(p,true);
 	
 	// Now that we're in the right directory, add the file to the directory.
 	//cout << "Adding file " << n << " to directory " << curr->getName() << endl;
@@ -107,37 +71,67 @@ void DirTree::add(string p, string n)
 }
 
 
-DirNode* DirTree::getDir(string p)
-// Try to obtain a directory given its name.
+void DirTree::attach(DirNode* d, vector<FileNode*>* f, vector<DirNode*>* s)
+// Attach an already-built set of files and sub-directories to a directory.
+// Used to merge in directories read by the indexer's workers.
 {
-	vector<string>* path_toks = tokenizeV(p.substr(root->getName().size()),"/");
+	for (size_t i = 0; i < s->size(); i++)
+		d->addDirectory(s->at(i));
+
+	for (size_t i = 0; i < f->size(); i++)
+		d->addFile(f->at(i));
+
+	numfiles += f->size();
+}
+
+
+DirNode* DirTree::findDir(string p, bool make)
+// Follow a path down from the root, one directory at a time. Each directory
+// finds the next by name in its index, so this takes as long as the path is
+// deep, no matter how big the directories are. If asked to, directories that
+// don't exist are made along the way; otherwise, NULL is returned.
+{
+	if (p.compare(0,root->getName().size(),root->getName()) != 0)
+		return NULL;
 	
-	// Set the current node to the root of the directory tree, and start an
-	// iterator on the current node's directory list.
 	DirNode* curr = root;
-	list<DirNode*>* dirs = curr->getDirectories();
-	list<DirNode*>::iterator d = dirs->begin();
+	size_t start = root->getName().size();
 	
-	// While there are still more paths to navigate...
-	for (size_t i = 0; i < path_toks->size();)
+	while (start < p.size())
 	{
-		// Scan the directory list for the current directory.
-		for (;d != dirs->end() && path_toks->at(i).compare((*d)->getName()) != 0 && !isLessThan(path_toks->at(i),(*d)->getName());d++);
+		size_t end = p.find('/',start);
+		if (end == string::npos)
+			end = p.size();
 		
-		// If current directory exists, go to it.
-		if (d != dirs->end() && path_toks->at(i).compare((*d)->getName()) == 0)
+		// Skip empty names, from doubled up slashes.
+		if (end > start)
 		{
-			curr = *d;
-			dirs = curr->getDirectories();
-			d = dirs->begin();
-			i++;
+			string dn = p.substr(start,end-start);
+			DirNode* next = curr->getDirectory(dn);
+			
+			if (next == NULL)
+			{
+				if (!make)
+					return NULL;
+				
+				next = new DirNode(curr,dn);
+				curr->addDirectory(next);
+			}
+			
+			curr = next;
 		}
-		// If current directory does not exist, return null
-		else
-			return NULL;
+		
+		start = end+1;
 	}
 	
-	return *d;
+	return curr;
+}
+
+
+DirNode* DirTree::getDir(string p)
+// Try to obtain a directory given its path.
+{
+	return findDir(p,false);
 }
 
 
@@ -150,17 +144,7 @@ FileNode* DirTree::getFile(string p, string n)
 	// If directory doesn't exist, return null.
 	if (dir == NULL) return NULL;
 	
-	list<FileNode*>* files = dir->getFiles();
-	
-	// Now scan the current directory's file list
-	list<FileNode*>::iterator f = files->begin();
-	for (; f != files->end() && (*f)->getName().compare(n) == 0; f++);
-	
-	// If the file doesn't exist, return null.
-	if (f == files->end())
-		return NULL;
-	
-	return *f;
+	return dir->getFile(n);
 }
 //==============================================================================
 
@@ -180,24 +164,21 @@ void DirTree::dropBranch(DirNode* d)
 {
 	delete d;
 }
-//==============================================================================
 
 
-//==============================================================================
-// Convenience methods.
-//==============================================================================
-list<FileNode*>* DirTree::getAllFilesFrom(DirNode* d)
-// Return a pointer to the list of all files in the given directory.
+void DirTree::layOut()
+// Lay the arena out in the tree's order, so every directory's files are one
+// run of rows, and drop the rows and names of files that have gone. Done once
+// the tree has settled, such as after a build or a refresh.
 {
-	return d->getAllFiles();
+	FileNode::getArena()->layOut(root);
 }
+//==============================================================================
 
-list<FileNode*>* DirTree::getFileList()
-// Return a pointer to the list of all files in this tree.
-{
-	return getAllFilesFrom(root);
-}
 
+//==============================================================================
+// Convenience methods.
+//==============================================================================
 string DirTree::getRootPath()
 // Returns the name (path) of the root node.
 {
@@ -215,4 +196,11 @@ int DirTree::getNumFiles()
 {
 	return numfiles;
 }
+
+void DirTree::setNumFiles(int n)
+// Set the number of files in the file tree, for trees that weren't built one
+// file at a time (such as those loaded from a snapshot).
+{
+	numfiles = n;
+}
 //==============================================================================
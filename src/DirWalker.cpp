@@ -0,0 +1,529 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			DirWalker.cpp
+// Programmer:			Matthew Hydock
+//
+// File description:	A parallel directory walker. Each worker reads one
+//						directory at a time, queues the sub-directories it finds
+//						on its own deque, and reads the files' names and
+//						attributes. Workers with nothing left to do steal from
+//						the others. Sub-directories are opened relative to the
+//						directory they were found in, and files are stat'd
+//						relative to them too.
+//==============================================================================
+
+#include "DirWalker.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+
+//==============================================================================
+// Helpers.
+//==============================================================================
+static bool nameOrder(const string& a, const string& b)
+// Sorting predicate, so that every listing comes out in the same order no
+// matter which worker read it.
+{
+	return compareNames(a,b) < 0;
+}
+//==============================================================================
+
+
+//==============================================================================
+// Constructor/Deconstructor
+//==============================================================================
+DirWalker::DirWalker(int t)
+// Make a walker with the given number of workers. Zero means one worker per
+// online processor.
+{
+	if (t <= 0)
+		t = sysconf(_SC_NPROCESSORS_ONLN);
+	if (t <= 0)
+		t = 1;
+
+	num_threads = t;
+	running = false;
+	stopping = false;
+	pending = 0;
+	generation = 0;
+	files_found = 0;
+	dirs_found = 0;
+	open_fds = 0;
+
+	for (int i = 0; i < num_threads; i++)
+	{
+		WorkQueue* q = new WorkQueue;
+		pthread_mutex_init(&q->lock,NULL);
+		queues.push_back(q);
+	}
+
+	pthread_mutex_init(&work_lock,NULL);
+	pthread_cond_init(&work_cond,NULL);
+	pthread_mutex_init(&results_lock,NULL);
+}
+
+DirWalker::~DirWalker()
+// Wait for any workers still going, then throw away whatever was not
+// collected.
+{
+	wait();
+
+	for (size_t i = 0; i < queues.size(); i++)
+	{
+		pthread_mutex_destroy(&queues[i]->lock);
+		delete queues[i];
+	}
+
+	for (list<DirListing*>::iterator i = results.begin(); i != results.end(); i++)
+	{
+		for (size_t j = 0; j < (*i)->dirs.size(); j++)
+			delete (*i)->dirs[j];
+		delete *i;
+	}
+
+	pthread_mutex_destroy(&work_lock);
+	pthread_cond_destroy(&work_cond);
+	pthread_mutex_destroy(&results_lock);
+}
+//==============================================================================
+
+
+//==============================================================================
+// Worker methods.
+//==============================================================================
+void* DirWalker::workerMain(void* a)
+// Entry point for the worker threads.
+{
+	WorkerArgs* args = (WorkerArgs*)a;
+	args->walker->work(args->id);
+
+	return NULL;
+}
+
+void DirWalker::work(int id)
+// Keep reading directories until there are none left anywhere.
+{
+	PendingDir d;
+	int seen;
+	bool stopped;
+
+	while (true)
+	{
+		// Note how many directories have been queued so far, so a directory
+		// queued while this worker is looking around is not slept through.
+		pthread_mutex_lock(&work_lock);
+		seen = generation;
+		stopped = stopping;
+		pthread_mutex_unlock(&work_lock);
+
+		if (takeDirectory(id,d))
+		{
+			// Once stopped, queued directories are just thrown away, so the
+			// workers run out of things to do quickly.
+			if (!stopped)
+				readDirectory(id,d);
+			else
+				closePending(d);
+
+			pthread_mutex_lock(&work_lock);
+			pending--;
+			if (pending == 0)
+				pthread_cond_broadcast(&work_cond);
+			pthread_mutex_unlock(&work_lock);
+		}
+		else
+		{
+			// Nothing to take or steal. If other workers are still reading,
+			// they may turn up more directories, so sleep until they do.
+			pthread_mutex_lock(&work_lock);
+			while (pending > 0 && generation == seen)
+				pthread_cond_wait(&work_cond,&work_lock);
+			bool done = (pending == 0);
+			pthread_mutex_unlock(&work_lock);
+
+			if (done)
+				return;
+		}
+	}
+}
+
+bool DirWalker::takeDirectory(int id, PendingDir& d)
+// Take the newest directory off this worker's own deque. If it is empty, try
+// to steal the oldest directory from each of the other workers in turn.
+{
+	WorkQueue* q = queues[id];
+
+	pthread_mutex_lock(&q->lock);
+	if (!q->dirs.empty())
+	{
+		d = q->dirs.back();
+		q->dirs.pop_back();
+		pthread_mutex_unlock(&q->lock);
+		return true;
+	}
+	pthread_mutex_unlock(&q->lock);
+
+	for (int i = 1; i < num_threads; i++)
+	{
+		q = queues[(id+i)%num_threads];
+
+		pthread_mutex_lock(&q->lock);
+		if (!q->dirs.empty())
+		{
+			d = q->dirs.front();
+			q->dirs.pop_front();
+			pthread_mutex_unlock(&q->lock);
+			return true;
+		}
+		pthread_mutex_unlock(&q->lock);
+	}
+
+	return false;
+}
+
+void DirWalker::pushDirectory(int id, DirNode* d, int fd)
+// Queue a directory on the given worker's deque, and wake anyone who is idle.
+// The directory may already be open, in which case its descriptor goes with
+// it.
+{
+	PendingDir p;
+	p.dir = d;
+	p.fd = fd;
+
+	pthread_mutex_lock(&work_lock);
+	pending++;
+	pthread_mutex_unlock(&work_lock);
+
+	pthread_mutex_lock(&queues[id]->lock);
+	queues[id]->dirs.push_back(p);
+	pthread_mutex_unlock(&queues[id]->lock);
+
+	pthread_mutex_lock(&work_lock);
+	generation++;
+	pthread_cond_broadcast(&work_cond);
+	pthread_mutex_unlock(&work_lock);
+}
+
+void DirWalker::closePending(PendingDir d)
+// Close a queued directory's descriptor, if it has one.
+{
+	if (d.fd < 0)
+		return;
+
+	close(d.fd);
+	__sync_fetch_and_sub(&open_fds,1);
+}
+
+void DirWalker::readDirectory(int id, PendingDir p)
+// Read a single directory. Sub-directories are opened and queued before the
+// file nodes are built, so idle workers can start on them while this one is
+// busy. A directory that wasn't opened when it was queued is opened by its
+// full path.
+{
+	vector<string> file_names;
+	vector<string> dir_names;
+	map<string,struct stat> attrs;
+	struct stat st;
+	DirNode* d = p.dir;
+
+	if (p.fd < 0)
+	{
+		p.fd = openDirectory(d);
+		if (p.fd < 0)
+			return;
+
+		__sync_fetch_and_add(&open_fds,1);
+	}
+
+	if (!listDirectory(p.fd,&file_names,&dir_names,&st,&attrs))
+	{
+		cout << "WARNING: Could not read directory " << d->getPath() << endl;
+		closePending(p);
+		return;
+	}
+
+	// Remember when the directory was last changed, for the index snapshot.
+	d->setTimes(st.st_mtime,st.st_ctime);
+
+	sort(file_names.begin(),file_names.end(),nameOrder);
+	sort(dir_names.begin(),dir_names.end(),nameOrder);
+
+	DirListing* l = new DirListing;
+	l->dir = d;
+
+	for (size_t i = 0; i < dir_names.size(); i++)
+	{
+		DirNode* temp = new DirNode(d,dir_names[i]);
+		l->dirs.push_back(temp);
+
+		// The count is read atomically, like it is written. It can still run
+		// a little over when several workers check it at once, which doesn't
+		// matter.
+		int fd = -1;
+		if (__sync_fetch_and_add(&open_fds,0) < WALK_MAX_FDS)
+		{
+			fd = openDirectory(p.fd,dir_names[i]);
+			if (fd >= 0)
+				__sync_fetch_and_add(&open_fds,1);
+		}
+
+		pushDirectory(id,temp,fd);
+	}
+
+	closePending(p);
+
+	// Keep each file's attributes along with its name, so they don't have to
+	// be read again when the file's node is made.
+	l->file_attrs.resize(file_names.size());
+	l->have_attrs.resize(file_names.size(),0);
+
+	for (size_t i = 0; i < file_names.size(); i++)
+	{
+		map<string,struct stat>::iterator a = attrs.find(file_names[i]);
+
+		if (a != attrs.end())
+		{
+			l->file_attrs[i] = a->second;
+			l->have_attrs[i] = 1;
+		}
+	}
+
+	l->file_names.swap(file_names);
+
+	__sync_fetch_and_add(&files_found,(int)l->file_names.size());
+	__sync_fetch_and_add(&dirs_found,(int)l->dirs.size());
+
+	pthread_mutex_lock(&results_lock);
+	results.push_back(l);
+	pthread_mutex_unlock(&results_lock);
+}
+//==============================================================================
+
+
+//==============================================================================
+// Public methods.
+//==============================================================================
+int DirWalker::openDirectory(DirNode* d)
+// Open a directory by its full path. Returns -1, with a warning, if it can't
+// be opened.
+{
+	string path = d->getPath();
+	int fd = open(path.c_str(),O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+	if (fd < 0)
+		cout << "WARNING: Could not open directory " << path << endl;
+
+	return fd;
+}
+
+int DirWalker::openDirectory(int fd, string name)
+// Open a sub-directory of an open directory, without following links. Returns
+// -1 if it can't be opened; it is tried again by its full path later, which
+// gives a proper warning if it still can't be.
+{
+	return openat(fd,name.c_str(),O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+}
+
+bool DirWalker::listDirectory(int fd, vector<string>* f, vector<string>* d, struct stat* st, map<string,struct stat>* attrs)
+// Read the names of the files and sub-directories in an open directory,
+// leaving out hidden files, tag files, and anything that is neither a file nor
+// a directory. Also gets the directory's own attributes. Some file systems
+// don't say what each entry is, in which case it is stat'd instead. If given
+// somewhere to put them, every file's attributes are read and kept, so sizes
+// and times are known from the walk without a stat on the main thread later.
+// The descriptor is left open. Returns false if the directory couldn't be
+// read.
+{
+	// Reading the directory through a copy of the descriptor, so closing it
+	// afterwards leaves the original alone.
+	int dup_fd = dup(fd);
+	DIR* dp = (dup_fd < 0) ? NULL : fdopendir(dup_fd);
+
+	if (dp == NULL)
+	{
+		if (dup_fd >= 0)
+			close(dup_fd);
+		return false;
+	}
+
+	rewinddir(dp);
+
+	if (fstat(fd,st) != 0)
+		memset(st,0,sizeof(struct stat));
+
+	for (dirent* dr = readdir(dp); dr != NULL; dr = readdir(dp))
+	{
+		if (strcmp(dr->d_name, "..") == 0 || strcmp(dr->d_name, ".") == 0)
+			continue;
+
+		unsigned char type = dr->d_type;
+		struct stat a;
+		bool have_attr = false;
+
+		if (type == DT_UNKNOWN)
+		{
+			if (fstatat(fd,dr->d_name,&a,AT_SYMLINK_NOFOLLOW) != 0)
+				continue;
+
+			have_attr = true;
+
+			if (S_ISREG(a.st_mode))
+				type = DT_REG;
+			else if (S_ISDIR(a.st_mode))
+				type = DT_DIR;
+		}
+
+		if (type == DT_REG)
+		{
+			// If a file, but not a tag file, add to file list
+			if (dr->d_name[0] != '.' && strstr(dr->d_name, ".tags") == NULL)
+			{
+				f->push_back(dr->d_name);
+
+				if (attrs != NULL && !have_attr)
+					have_attr = fstatat(fd,dr->d_name,&a,AT_SYMLINK_NOFOLLOW) == 0;
+
+				if (attrs != NULL && have_attr)
+					(*attrs)[dr->d_name] = a;
+			}
+		}
+		else if (type == DT_DIR)
+			d->push_back(dr->d_name);
+	}
+
+	closedir(dp);
+
+	return true;
+}
+
+void DirWalker::start(DirNode* root)
+// Start walking from the given directory. Returns immediately; use wait() or
+// isDone() to find out when the walk is over.
+{
+	vector<DirNode*> roots(1,root);
+	start(&roots);
+}
+
+void DirWalker::start(vector<DirNode*>* roots)
+// Start walking from several directories at once, such as the new directories
+// found by a refresh.
+{
+	if (running || roots->empty())
+		return;
+
+	running = true;
+
+	pthread_mutex_lock(&work_lock);
+	pending = roots->size();
+	stopping = false;
+	pthread_mutex_unlock(&work_lock);
+
+	for (size_t i = 0; i < roots->size(); i++)
+	{
+		PendingDir p;
+		p.dir = roots->at(i);
+		p.fd = -1;
+		queues[0]->dirs.push_back(p);
+	}
+
+	args.resize(num_threads);
+	threads.resize(num_threads);
+
+	for (int i = 0; i < num_threads; i++)
+	{
+		args[i].walker = this;
+		args[i].id = i;
+		pthread_create(&threads[i],NULL,workerMain,&args[i]);
+	}
+}
+
+void DirWalker::wait()
+// Block until every worker has finished.
+{
+	if (!running)
+		return;
+
+	for (int i = 0; i < num_threads; i++)
+		pthread_join(threads[i],NULL);
+
+	threads.clear();
+	running = false;
+}
+
+void DirWalker::stop()
+// Give up on the walk, and wait for the workers to finish what they are doing.
+// Whatever has been read so far can still be collected.
+{
+	pthread_mutex_lock(&work_lock);
+	stopping = true;
+	pthread_mutex_unlock(&work_lock);
+
+	wait();
+}
+
+bool DirWalker::isDone()
+// Check if the walk is over, without blocking.
+{
+	pthread_mutex_lock(&work_lock);
+	bool done = (pending == 0);
+	pthread_mutex_unlock(&work_lock);
+
+	return done;
+}
+
+list<DirListing*>* DirWalker::takeResults()
+// Hand over every listing finished so far, making the nodes for their files.
+// The caller owns the returned list and the listings in it.
+{
+	list<DirListing*>* temp = new list<DirListing*>;
+
+	pthread_mutex_lock(&results_lock);
+	temp->swap(results);
+	pthread_mutex_unlock(&results_lock);
+
+	for (list<DirListing*>::iterator i = temp->begin(); i != temp->end(); i++)
+	{
+		DirListing* l = *i;
+		l->files.reserve(l->file_names.size());
+
+		for (size_t j = 0; j < l->file_names.size(); j++)
+			if (l->have_attrs[j])
+				l->files.push_back(new FileNode(l->dir,l->file_names[j],&l->file_attrs[j],"","",FILE_HAVE_ATTR));
+			else
+				l->files.push_back(new FileNode(l->dir,l->file_names[j]));
+
+		l->file_names.clear();
+		l->file_attrs.clear();
+		l->have_attrs.clear();
+	}
+
+	return temp;
+}
+
+int DirWalker::getNumThreads()
+{
+	return num_threads;
+}
+
+int DirWalker::getFilesFound()
+{
+	return files_found;
+}
+
+int DirWalker::getDirsFound()
+{
+	return dirs_found;
+}
+
+int DirWalker::getDirsPending()
+// Get the number of directories queued or being read.
+{
+	pthread_mutex_lock(&work_lock);
+	int p = pending;
+	pthread_mutex_unlock(&work_lock);
+
+	return p;
+}
+//==============================================================================
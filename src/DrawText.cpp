@@ -1,11 +1,12 @@
 //==============================================================================
 // Date Created:		3 May 2011
-// Last Updated:		29 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			DrawText.h
 // Programmer:			Matthew Hydock
 //
-// File description:	Header for a class that renders text to a texture.
+// File description:	Header for a class that draws text, a quad per character,
+//						from the glyph atlas of its font.
 //==============================================================================
 
 #include "DrawText.h"
@@ -28,14 +29,14 @@ DrawText::DrawText(string t,string f,int s,float x,float y,text_align a)
 	horz_padding = 0;
 	vert_padding = 0;
 
-	texture = NULL;
+	atlas = NULL;
 
 	refreshTexture();
 }
 	
 DrawText::~DrawText()
+// The atlas is shared, and stays for the next text to use.
 {
-	delete texture;
 }
 
 //==============================================================================
@@ -187,53 +188,77 @@ float* DrawText::getBackgroundColor()
 //==============================================================================
 // Methods for drawing.
 //==============================================================================
-void DrawText::refreshTexture()
-// Using the stored font and text, build a texture.
+size_t DrawText::getByteSize()
+// Roughly how much memory the text takes up, for caches to go by.
 {
-	// Delete the old texture.
-	if (texture != NULL)
-		delete texture;
-	
-	// Initialize the texture object.
-	texture = new TextureObject();
+	return sizeof(DrawText) + text.capacity() + name.capacity() + vertices.capacity()*sizeof(TextVertex);
+}
 
-	// Make SDL surfaces to render text to.
-	SDL_Surface* initial = NULL;
-	
-	// Open the font.
-	TTF_Font* font = TTF_OpenFont(font_path.c_str(),font_size);
-	SDL_Color fg_color = {255*text_color[0],255*text_color[1],255*text_color[2],255*text_color[3]};
+static TextVertex textVertex(float s, float t, float x, float y)
+// Make one corner of a character's quad.
+{
+	TextVertex v;
+	v.s = s;
+	v.t = t;
+	v.x = x;
+	v.y = y;
+	v.z = 0;
 	
-	// Make the initial text buffer.	
-	initial = TTF_RenderText_Blended(font, text.c_str(), fg_color);
-	TTF_CloseFont(font);
+	return v;
+}
 
-	// Load the new texture into the texture object, provided something was
-	// actually rendered.
-	if (initial != NULL)
-	{
-		texture->setTexture(initial);
-		width			= texture->getWidth();
-		height			= texture->getHeight();
-		aspect_ratio	= texture->getAspectRatio();
+void DrawText::refreshTexture()
+// Lay the text out as a quad per character, using the glyphs in the font's
+// atlas. Nothing is rendered or uploaded, unless the text has a character the
+// atlas hasn't seen before. The text color is applied when drawing.
+{
+	atlas = FontAtlas::get(font_path,font_size);
+	vertices.clear();
 	
-		// Free the surface
-		SDL_FreeSurface(initial);
-	}
-	else
-	// If no text was rendered, just set everything to the defaults.
+	// Without the font, or without any text, just set everything to the
+	// defaults.
+	if (atlas == NULL || text.empty())
 	{
-		texture			= NULL;
 		width			= 0;
 		height			= 0;
+		text_width		= 0;
+		text_height		= 0;
 		aspect_ratio	= 1;
+		return;
 	}
+	
+	float h = atlas->getLineHeight();
+	float pen = 0;
+	float right = 0;
+	
+	vertices.reserve(text.size()*4);
+	
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		Glyph* g = atlas->getGlyph(text[i]);
+		
+		if (g->w > 0)
+		{
+			// Corners go in the same order as drawQuad's, from the top left.
+			vertices.push_back(textVertex(g->x,g->y,pen,0));
+			vertices.push_back(textVertex(g->x,g->y+h,pen,-h));
+			vertices.push_back(textVertex(g->x+g->w,g->y+h,pen+g->w,-h));
+			vertices.push_back(textVertex(g->x+g->w,g->y,pen+g->w,0));
+		}
 		
-//	printGlError();
+		right = max(right,pen+g->w);
+		pen += g->advance;
+	}
+	
+	text_width		= max(pen,right);
+	text_height		= h;
+	width			= text_width;
+	height			= text_height;
+	aspect_ratio	= (height > 0) ? width/height : 1;
 }
 		
 void DrawText::draw()
-// Draw the text.
+// Draw the text, all of its characters at once.
 {	
 	glPushMatrix();
 		glTranslatef(xPos,yPos,0);
@@ -251,9 +276,33 @@ void DrawText::draw()
 		// Draw the solid background.
 		drawQuad(0,0,width+2*horz_padding,height+2*vert_padding,bg_color,NULL);
 		
-		// Make text visible and draw it.
-		glTranslatef(0,0,1);
-		drawQuad(horz_padding,vert_padding,width,height,WHITE,texture);
+		// Make text visible and draw it, stretched if its size has been set.
+		glTranslatef(horz_padding,-vert_padding,1);
+		
+		if (!vertices.empty())
+		{
+			glScalef(width/text_width,height/text_height,1);
+			
+			// The texture coordinates are in pixels, so scale them to the
+			// atlas, which may have grown since the text was laid out.
+			glMatrixMode(GL_TEXTURE);
+			glPushMatrix();
+			glLoadIdentity();
+			glScalef(1.0/atlas->getWidth(),1.0/atlas->getHeight(),1);
+			
+			atlas->loadTexture();
+			glColor4fv(text_color);
+			
+			glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+				glInterleavedArrays(GL_T2F_V3F,sizeof(TextVertex),&vertices[0]);
+				glDrawArrays(GL_QUADS,0,vertices.size());
+			glPopClientAttrib();
+			
+			atlas->unloadTexture();
+			
+			glPopMatrix();
+			glMatrixMode(GL_MODELVIEW);
+		}
 	glPopMatrix();
 }
 //==============================================================================
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		26 March 2012
-// Last Updated:		29 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			FileNode.h
 // Programmer:			Matthew Hydock
@@ -14,29 +14,57 @@
 
 MimeIdentifier FileNode::mrmime = MimeIdentifier();
 
+// Never deleted, so it outlives any file still around when the program ends.
+TreeArena* FileNode::arena = new TreeArena();
+
 //==============================================================================
 // Constructor and deconstructor.
 //==============================================================================
 FileNode::FileNode(DirNodePrototype* p, string n)
-// Create a filenode and set its attributes.	
+// Create a filenode. Its attributes, type, and tags are read the first time
+// they are asked for, so files that are never looked at cost next to nothing.
+{
+	parent = p;
+	tags = NULL;
+	row = arena->allocate(this,n);
+}
+
+FileNode::FileNode(DirNodePrototype* p, string n, struct stat* a, string m, string t, int k)
+// Create a filenode from metadata that is already known (such as from an index
+// snapshot), without touching the file itself. The tags are given as one
+// space-separated string. Only the parts flagged in k are used; the rest are
+// read when first asked for, as usual.
 {
-	//cout << "Trying to load file " << n << " located in " << p->getName() << endl;
-	name = n;
 	parent = p;
+	tags = NULL;
+	row = arena->allocate(this,n);
 	
-	string temp_string = getPath() + n;
-	stat(temp_string.c_str(), &attr);
+	if (k & FILE_HAVE_ATTR)
+	{
+		setAttributes(a);
+		arena->known[row] |= FILE_HAVE_ATTR;
+	}
 	
-	obtainType();
-
-	setTags();
+	if (k & FILE_HAVE_TYPE)
+		setType(m);
 	
-	//cout << "File " << name << " loaded.\n";
+	if (k & FILE_HAVE_TAGS)
+	{
+		list<string>* temp_tags = tokenizeL(t," ");
+		if (temp_tags != NULL && !temp_tags->empty())
+			tags = temp_tags;
+		else
+			delete temp_tags;
+		
+		arena->known[row] |= FILE_HAVE_TAGS;
+	}
 }
 
 FileNode::~FileNode()
-// Trivial deconstructor.
+// Give the file's row back to the arena.
 {
+	arena->release(row);
+	delete tags;
 }
 //==============================================================================
 
@@ -51,12 +79,12 @@ string FileNode::getPath()
 
 string FileNode::getName()
 {
-	return name;
+	return arena->nameAt(row);
 }
 
 void FileNode::setName(string n)
 {
-	name = n;
+	arena->setName(row,n);
 }
 
 DirNodePrototype* FileNode::getParent()
@@ -73,26 +101,134 @@ void FileNode::setParent(DirNodePrototype* p)
 
 //==============================================================================
 // Getters for MIME data and real file attributes. This data cannot be changed,
-// only retrieved.
+// only retrieved. Each is read from the file the first time it is asked for.
 //==============================================================================
 string FileNode::getMimetype()
 {
-	return mime_type;
+	if (!(arena->known[row] & FILE_HAVE_TYPE))
+		obtainType();
+	
+	return *arena->mimes[arena->mime[row]].type;
+}
+
+const string* FileNode::getSharedMimetype()
+// Get the file's mime-type as the one copy shared by every file of that type,
+// so types can be told apart just by comparing pointers.
+{
+	if (!(arena->known[row] & FILE_HAVE_TYPE))
+		obtainType();
+	
+	return arena->mimes[arena->mime[row]].type;
 }
 
 string FileNode::getDefaultApp()
 {
-	return default_app;
+	if (!(arena->known[row] & FILE_HAVE_TYPE))
+		obtainType();
+	
+	return arena->mimes[arena->mime[row]].app;
 }
 
 enum filetype FileNode::getMimeEnum()
 {
-	return mime_enum;
+	if (!(arena->known[row] & FILE_HAVE_TYPE))
+		obtainType();
+	
+	return arena->getMimeEnum(row);
 }
 
 struct stat FileNode::getAttributes()
+// Get the file's attributes as a struct stat. Only the fields that are kept
+// are filled in; the rest are zero.
 {
-	return attr;
+	if (!(arena->known[row] & FILE_HAVE_ATTR))
+		obtainAttributes();
+	
+	struct stat a;
+	memset(&a,0,sizeof(a));
+	
+	a.st_ino = arena->ino[row];
+	a.st_size = arena->size[row];
+	a.st_blocks = arena->blocks[row];
+	a.st_mtime = arena->mtime[row];
+	a.st_ctime = arena->ctime[row];
+	a.st_mode = arena->mode[row];
+	
+	return a;
+}
+
+off_t FileNode::getSize()
+{
+	if (!(arena->known[row] & FILE_HAVE_ATTR))
+		obtainAttributes();
+	
+	return arena->size[row];
+}
+
+blkcnt_t FileNode::getBlocks()
+{
+	if (!(arena->known[row] & FILE_HAVE_ATTR))
+		obtainAttributes();
+	
+	return arena->blocks[row];
+}
+
+time_t FileNode::getModifiedTime()
+{
+	if (!(arena->known[row] & FILE_HAVE_ATTR))
+		obtainAttributes();
+	
+	return arena->mtime[row];
+}
+
+mode_t FileNode::getMode()
+{
+	if (!(arena->known[row] & FILE_HAVE_ATTR))
+		obtainAttributes();
+	
+	return arena->mode[row];
+}
+
+ino_t FileNode::getInode()
+{
+	if (!(arena->known[row] & FILE_HAVE_ATTR))
+		obtainAttributes();
+	
+	return arena->ino[row];
+}
+
+void FileNode::setType(string m)
+// Set the file's mime-type, when it has been worked out elsewhere (such as by
+// prefetch()).
+{
+	bool counted = arena->known[row] & FILE_COUNTED;
+	
+	if (counted)
+		parent->fileChanging(this);
+	
+	// Working out the default app and kind means searching tables, so it is
+	// only done the first time a type turns up.
+	int n = arena->findMime(m);
+	if (n < 0)
+		n = arena->addMime(m,mrmime.setDefaultApp(m),mrmime.enumFileType(m));
+	
+	arena->mime[row] = n;
+	arena->known[row] |= FILE_HAVE_TYPE;
+	
+	if (counted)
+		parent->fileChanged(this);
+}
+
+int FileNode::getKnown()
+// Get which parts of the metadata have been read, as FILE_HAVE_* flags.
+{
+	return arena->getKnown(row);
+}
+
+bool FileNode::hasType()
+// Check if the file's type has been read yet, without reading it.
+{
+	return (arena->known[row] & FILE_HAVE_TYPE) != 0;
 }
 //==============================================================================
 
@@ -113,6 +249,9 @@ void FileNode::setTags()
 		string line = "";
 		list<string>* temp_tags = NULL;
 	
+		if (tags == NULL)
+			tags = new list<string>;
+	
 //		cout << "trying to open " << tag_file << endl;
 
 		// Read in the tag file one line at a time until EOF.
@@ -121,33 +260,230 @@ void FileNode::setTags()
 		{
 			getline(tag_stream,line);
 			temp_tags = tokenizeL(line," \n");
-			if (temp_tags != NULL)	append(&tags,temp_tags);
+			if (temp_tags != NULL)	append(tags,temp_tags);
 		}
 		// Done reading in tags.
 	}
+	
+	arena->known[row] |= FILE_HAVE_TAGS;
+}
+
+void FileNode::refresh(struct stat* a)
+// Re-read the file's attributes after the file has changed, or take the ones
+// given if they have just been read. Its type and tags are read again the next
+// time they are asked for.
+{
+	bool counted = arena->known[row] & FILE_COUNTED;
+	
+	if (counted)
+		parent->fileChanging(this);
+	
+	arena->known[row] &= FILE_COUNTED;
+	arena->mime[row] = 0;
+	
+	delete tags;
+	tags = NULL;
+	
+	if (a == NULL)
+		readAttributes();
+	else
+		setAttributes(a);
+	
+	arena->known[row] |= FILE_HAVE_ATTR;
+	
+	if (counted)
+		parent->fileChanged(this);
 }
 
 void FileNode::rebuildTags()
 {
-	tags.clear();
+	delete tags;
+	tags = NULL;
 	
 	setTags();
 }
 
 list<string>* FileNode::getTags()
+// Get the file's tags. Files without any all share one empty list.
 {
-	return &tags;
+	static list<string> no_tags;
+	
+	if (!(arena->known[row] & FILE_HAVE_TAGS))
+		setTags();
+	
+	return (tags != NULL) ? tags : &no_tags;
 }
 
 void FileNode::obtainType()
 // Scan through the mime table, and return the type of the requested file.
 {
+	// The attributes are read along with the type, so a refresh can tell if
+	// the type has gone out of date.
+	if (!(arena->known[row] & FILE_HAVE_ATTR))
+		obtainAttributes();
+	
 //	cout << "Obtaining MIME data...\n";
-	mime_type = mrmime.setFileType(getPath()+getName());
+	setType(mrmime.setFileType(getPath()+getName()));
 //	cout << "MIME type determined.\n";
-	mime_enum = mrmime.enumFileType(mime_type);
-//	cout << "MIME enum set.\n";
-	default_app = mrmime.setDefaultApp(mime_type);
-//	cout << "Default application set.\n";
+}
+
+void FileNode::obtainAttributes(struct stat* a)
+// Read the file's attributes for the first time, or take the ones given if
+// they have just been read.
+{
+	bool counted = arena->known[row] & FILE_COUNTED;
+	
+	if (counted)
+		parent->fileChanging(this);
+	
+	if (a == NULL)
+		readAttributes();
+	else
+		setAttributes(a);
+	
+	arena->known[row] |= FILE_HAVE_ATTR;
+	
+	if (counted)
+		parent->fileChanged(this);
+}
+
+void FileNode::readAttributes()
+// Read the file's attributes. If the file can't be read, they are left empty.
+{
+	string temp_string = getPath() + getName();
+	struct stat a;
+	
+	if (stat(temp_string.c_str(), &a) == 0)
+		setAttributes(&a);
+	else
+		setAttributes(NULL);
+}
+
+void FileNode::setAttributes(struct stat* a)
+// Keep the parts of a struct stat that are used, or clear them if given NULL.
+{
+	if (a == NULL)
+	{
+		arena->ino[row] = 0;
+		arena->size[row] = 0;
+		arena->blocks[row] = 0;
+		arena->mtime[row] = 0;
+		arena->ctime[row] = 0;
+		arena->mode[row] = 0;
+		return;
+	}
+	
+	arena->ino[row] = a->st_ino;
+	arena->size[row] = a->st_size;
+	arena->blocks[row] = a->st_blocks;
+	arena->mtime[row] = a->st_mtime;
+	arena->ctime[row] = a->st_ctime;
+	arena->mode[row] = a->st_mode;
+}
+
+TreeArena* FileNode::getArena()
+// Get the arena every file's metadata is kept in.
+{
+	return arena;
+}
+
+void FileNode::prefetch(vector<FileNode*>* f, int threads)
+// Read the metadata of a batch of files ahead of time, so it's ready before
+// they are drawn. The types are worked out in parallel (zero threads for one
+// per processor). Parts that are already known are skipped.
+{
+	vector<FileNode*> untyped;
+	vector<string> paths;
+	
+	prefetchAttributes(f,threads);
+	
+	for (size_t i = 0; i < f->size(); i++)
+	{
+		FileNode* temp = f->at(i);
+		
+		if (!(arena->known[temp->row] & FILE_HAVE_TAGS))
+			temp->setTags();
+		
+		if (!(arena->known[temp->row] & FILE_HAVE_TYPE))
+		{
+			untyped.push_back(temp);
+			paths.push_back(temp->getPath() + temp->getName());
+		}
+	}
+	
+	if (untyped.empty())
+		return;
+	
+	vector<string>* types = mrmime.classify(&paths,threads);
+	
+	for (size_t i = 0; i < untyped.size(); i++)
+		untyped[i]->setType(types->at(i));
+	
+	delete types;
+}
+
+void FileNode::prefetchAttributes(vector<FileNode*>* f, int threads)
+// Read the attributes of every file in a batch that doesn't have them yet.
+// The files are stat'd in parallel (zero threads for one per processor), and
+// the attributes handed over afterwards, on the calling thread.
+{
+	vector<FileNode*> unread;
+	vector<string> paths;
+	
+	for (size_t i = 0; i < f->size(); i++)
+		if (!(arena->known[f->at(i)->row] & FILE_HAVE_ATTR))
+		{
+			unread.push_back(f->at(i));
+			paths.push_back(f->at(i)->getPath() + f->at(i)->getName());
+		}
+	
+	if (unread.empty())
+		return;
+	
+	if (threads <= 0)
+		threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (threads <= 0)
+		threads = 1;
+	if ((size_t)threads > paths.size())
+		threads = paths.size();
+	
+	vector<struct stat> attrs(paths.size());
+	vector<char> found(paths.size(),0);
+	vector<StatJob> jobs(threads);
+	vector<pthread_t> workers(threads);
+	size_t slice = (paths.size()+threads-1)/threads;
+	
+	for (int i = 0; i < threads; i++)
+	{
+		jobs[i].paths = &paths;
+		jobs[i].attrs = &attrs;
+		jobs[i].found = &found;
+		jobs[i].begin = min(paths.size(),i*slice);
+		jobs[i].end = min(paths.size(),(i+1)*slice);
+	}
+	
+	// The calling thread takes the first slice itself, so a batch on one
+	// thread doesn't spawn anything.
+	for (int i = 1; i < threads; i++)
+		pthread_create(&workers[i],NULL,statWorker,&jobs[i]);
+	
+	statWorker(&jobs[0]);
+	
+	for (int i = 1; i < threads; i++)
+		pthread_join(workers[i],NULL);
+	
+	for (size_t i = 0; i < unread.size(); i++)
+		unread[i]->obtainAttributes(found[i] ? &attrs[i] : NULL);
+}
+
+void* FileNode::statWorker(void* j)
+// Thread body for prefetchAttributes(). Stats one slice of the batch.
+{
+	StatJob* job = (StatJob*)j;
+	
+	for (size_t i = job->begin; i < job->end; i++)
+		job->found->at(i) = stat(job->paths->at(i).c_str(),&job->attrs->at(i)) == 0;
+	
+	return NULL;
 }
 //==============================================================================
@@ -0,0 +1,189 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			FontAtlas.cpp
+// Programmer:			Matthew Hydock
+//
+// File description:	A texture holding the glyphs of one font at one size,
+//						rendered white so text can be drawn in any color. The
+//						glyphs are packed in rows, and the texture is only sent
+//						to the card again when a new glyph has been added.
+//==============================================================================
+
+#include "FontAtlas.h"
+
+map<pair<string,int>,FontAtlas*> FontAtlas::atlases;
+
+//==============================================================================
+// Constructors and Deconstructors
+//==============================================================================
+FontAtlas::FontAtlas(TTF_Font* f)
+// Make an atlas for an open font, and render the printable ASCII glyphs into
+// it. The atlas takes charge of the font.
+{
+	font = f;
+	line_height = TTF_FontHeight(font);
+
+	width			= ATLAS_WIDTH;
+	height			= ATLAS_START_HEIGHT;
+	aspect_ratio	= (float)width/(float)height;
+	pixels.resize(width*height,0);
+
+	pen_x = 0;
+	pen_y = 0;
+	dirty = true;
+
+	for (int c = 0; c < 256; c++)
+		rendered[c] = false;
+
+	for (int c = ' '; c <= '~'; c++)
+		renderGlyph(c);
+}
+
+FontAtlas::~FontAtlas()
+{
+	TTF_CloseFont(font);
+}
+//==============================================================================
+
+
+//==============================================================================
+// The font cache.
+//==============================================================================
+FontAtlas* FontAtlas::get(string path, int size)
+// Get the atlas for a font at the given size, opening the font the first time
+// it is asked for. Returns NULL if the font can't be opened, or if SDL_ttf
+// hasn't been started yet (as with labels made before main()), in which case
+// it is tried again next time.
+{
+	pair<string,int> key(path,size);
+	map<pair<string,int>,FontAtlas*>::iterator i = atlases.find(key);
+
+	if (i != atlases.end())
+		return i->second;
+
+	if (!TTF_WasInit())
+		return NULL;
+
+	TTF_Font* f = TTF_OpenFont(path.c_str(),size);
+	if (f == NULL)
+	{
+		cout << "WARNING: Could not open font " << path << endl;
+		return NULL;
+	}
+
+	FontAtlas* atlas = new FontAtlas(f);
+	atlases[key] = atlas;
+
+	return atlas;
+}
+//==============================================================================
+
+
+//==============================================================================
+// Glyph management.
+//==============================================================================
+void FontAtlas::renderGlyph(unsigned char c)
+// Render a glyph on its own, and copy its coverage into the next free cell.
+// The atlas grows if it has run out of room.
+{
+	Glyph& g = glyphs[c];
+	g.x = 0;
+	g.y = 0;
+	g.w = 0;
+	g.advance = 0;
+	rendered[c] = true;
+
+	int minx, maxx, miny, maxy, advance;
+	if (TTF_GlyphMetrics(font,c,&minx,&maxx,&miny,&maxy,&advance) == 0)
+		g.advance = advance;
+
+	if (c == '\0')
+		return;
+
+	char text[2] = {(char)c, '\0'};
+	SDL_Color white = {255,255,255,255};
+	SDL_Surface* s = TTF_RenderText_Blended(font,text,white);
+
+	if (s == NULL)
+		return;
+
+	int w = min(s->w,width);
+	int h = min(s->h,line_height);
+
+	// Start a new row if this one is full, and make room for it.
+	if (pen_x + w > width)
+	{
+		pen_x = 0;
+		pen_y += line_height+1;
+	}
+
+	while (pen_y + line_height > height)
+	{
+		height *= 2;
+		aspect_ratio = (float)width/(float)height;
+		pixels.resize(width*height,0);
+	}
+
+	SDL_LockSurface(s);
+	for (int y = 0; y < h; y++)
+	{
+		Uint32* row = (Uint32*)((Uint8*)s->pixels + y*s->pitch);
+		GLubyte* dest = &pixels[(pen_y+y)*width + pen_x];
+
+		for (int x = 0; x < w; x++)
+			dest[x] = (row[x] & s->format->Amask) >> s->format->Ashift;
+	}
+	SDL_UnlockSurface(s);
+
+	g.x = pen_x;
+	g.y = pen_y;
+	g.w = w;
+
+	pen_x += w+1;
+	dirty = true;
+
+	SDL_FreeSurface(s);
+}
+
+Glyph* FontAtlas::getGlyph(unsigned char c)
+// Get where a glyph is in the atlas, rendering it first if it hasn't been.
+{
+	if (!rendered[c])
+		renderGlyph(c);
+
+	return &glyphs[c];
+}
+
+int FontAtlas::getLineHeight()
+{
+	return line_height;
+}
+//==============================================================================
+
+
+//==============================================================================
+// Loading and unloading methods
+//==============================================================================
+void FontAtlas::loadTexture()
+// Bind the atlas, sending it to the card first if glyphs have been added since
+// it last was. Glyphs can be added before there is a GL context, so the
+// texture isn't made until it is first used.
+{
+	if (tex_id == 0)
+	{
+		initTexture();
+		dirty = true;
+	}
+
+	if (dirty)
+	{
+		glBindTexture(GL_TEXTURE_2D, tex_id);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, width, height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, &pixels[0]);
+		dirty = false;
+	}
+
+	TextureObject::loadTexture();
+}
+//==============================================================================
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		18 March 2011
-// Last Updated:		29 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			GSector.h
 // Programmer:			Matthew Hydock
@@ -14,12 +14,15 @@
 
 #include "GSector.h"
 
-GSector::GSector(DirNode* r, list<FileNode*>* f, float ra, float b, float w, string n)
+GSector::GSector(DirNode* r, list<FileNode*>* f, float ra, float b, float w, string n, StarLayout* l)
 // Creates a sector, with a list of files and the given dimensions. Can take a
-// DirNode for hierarchical functionality, but it is not necessary.
+// DirNode for hierarchical functionality, but it is not necessary. Stars are
+// put back where the layout (if any) says they were.
 {	
 //	cout << "making a sector\n";
 	
+	own_files = false;
+	
 	if (r != NULL)
 		setDirectory(r);
 	else
@@ -29,13 +32,35 @@ GSector::GSector(DirNode* r, list<FileNode*>* f, float ra, float b, float w, str
 	}
 	
 	if (root != NULL && n == "")
-		name = root->getName();
-	else
-		name = n;
+		n = root->getName();
 	
-	label = NULL;
+	init(ra,b,w,n,l);
+	
+//	cout << "sector created\n";
+}
+
+GSector::GSector(list<DirNode*>* m, float ra, float b, float w, string n, StarLayout* l)
+// Creates a sector that stands in for a number of directories at once, with
+// every file below any of them.
+{
+	own_files = false;
+	root = NULL;
+	
+	setMembers(m);
+	init(ra,b,w,n,l);
+}
+
+void GSector::init(float ra, float b, float w, string n, StarLayout* l)
+// Set up everything the constructors have in common, once the files are known,
+// and build the stars.
+{
+	name = n;
+	
+	seed = hashString((root != NULL) ? root->getPath() : name);
+	layout = l;
 	
 	singleSectorMode = false;
+	warm = false;
 	
 	radius = ra;
 	
@@ -47,20 +72,19 @@ GSector::GSector(DirNode* r, list<FileNode*>* f, float ra, float b, float w, str
 	thickness = pow(radius*2,.5);
 	
 	buildStars();
-	
-//	cout << "sector created\n";
 }
 
 GSector::~GSector()
-// Deletes all of the stars. Does not delete the file list or the directory node
-// as they are external values, and should be dealt with externally.
+// Deletes all of the stars. Does not delete the directory node, or a file list
+// that was handed in, as they are external values, and should be dealt with
+// externally.
 {
 	clearStars();
 	
 	cout << "stars deleted from " << name << endl;
 	
-//	if (root != NULL)
-//		delete files;
+	if (own_files)
+		delete files;
 		
 	cout << name << " is deleted.\n";
 }
@@ -71,18 +95,225 @@ GSector::~GSector()
 //==============================================================================
 void GSector::buildStars()
 // Erases the current star list, then creates new stars within the sector's
-// physical range.
+// physical range. Stars the layout knows go back where they were; the rest
+// have their positions all drawn at once, from a generator seeded the same
+// way every time.
 {
 	clearStars();
+	warm = false;
+	stars_changed = true;
+	
+	vector<Star*> unplaced;
 	
 	for (list<FileNode*>::iterator i = files->begin(); i != files->end(); i++)
 	{
 		Star* temp = new Star(*i);
-		temp->randomPosition(getArcBegin(),getArcEnd(),0,radius,-thickness,thickness);
-		if (temp->getDistance()+(temp->getRadius()) > radius)
-			temp->setDistance(radius-(temp->getRadius()));
 		stars.push_back(temp);
+		
+		if (!restoreStar(temp))
+			unplaced.push_back(temp);
+	}
+	
+	int n = unplaced.size();
+	if (n == 0)
+		return;
+	
+	vector<float> a(n);
+	vector<float> dis(n);
+	vector<float> dep(n);
+	
+	MTRand rng(seed);
+	Star::randomPositions(&rng,n,getArcBegin(),getArcEnd(),0,radius,-thickness,thickness,&a[0],&dis[0],&dep[0]);
+	
+	for (int k = 0; k < n; k++)
+	{
+		unplaced[k]->setPosition(a[k],dis[k],dep[k]);
+		keepInside(unplaced[k]);
+	}
+}
+
+bool GSector::restoreStar(Star* s)
+// Put a star back where the layout says it was. The layout keeps how far
+// across the arc it was, so it goes the same way across the arc the sector
+// has now, and moves along with it when the galaxy settles the arc with
+// setArc(). Returns false if the star has to be placed.
+{
+	float a, dis, dep;
+	
+	if (layout == NULL || !layout->find(s->getFile(),&a,&dis,&dep))
+		return false;
+	
+	s->setPosition(arc_begin+a*arc_width,dis*radius,dep*thickness);
+	keepInside(s);
+	
+	return true;
+}
+
+void GSector::recordLayout()
+// Tell the layout where every star is now.
+{
+	if (layout == NULL || radius <= 0 || thickness <= 0 || arc_width <= 0)
+		return;
+	
+	for (list<Star*>::iterator i = stars.begin(); i != stars.end(); i++)
+		layout->record((*i)->getFile(),((*i)->getAngle()-arc_begin)/arc_width,(*i)->getDistance()/radius,(*i)->getDepth()/thickness);
+}
+
+void GSector::placeStrays()
+// Put any stars that are outside the sector's arc, such as after the arc has
+// been moved or shrunk, back in it somewhere.
+{
+	MTRand rng(seed);
+	
+	for (list<Star*>::iterator i = stars.begin(); i != stars.end(); i++)
+		if ((*i)->getAngle() > getArcEnd() || (*i)->getAngle() < getArcBegin())
+		{
+			placeStar(*i,&rng);
+			stars_changed = true;
+		}
+}
+
+void GSector::placeStar(Star* s, MTRand* r)
+// Put a star somewhere random within the sector, keeping it inside the rim.
+{
+	s->randomPosition(r,getArcBegin(),getArcEnd(),0,radius,-thickness,thickness);
+	keepInside(s);
+}
+
+void GSector::keepInside(Star* s)
+// Pull a star in from the rim if it pokes out past it.
+{
+	if (s->getDistance()+(s->getRadius()) > radius)
+		s->setDistance(radius-(s->getRadius()));
+}
+
+void GSector::addFiles(list<FileNode*>* f)
+// Add stars for files that have turned up since the sector was built. Files
+// that already have a star are skipped, as are files already in the file list
+// (as a sector made for a new directory lists what was in it already).
+{
+	set<FileNode*> have_star;
+	for (list<Star*>::iterator i = stars.begin(); i != stars.end(); i++)
+		have_star.insert((*i)->getFile());
+	
+	set<FileNode*> have_file(files->begin(),files->end());
+	
+	// Carry on from a different point for each batch, so new stars don't all
+	// land on top of the first ones.
+	MTRand rng(seed + stars.size());
+	
+	warm = false;
+	stars_changed = true;
+	
+	for (list<FileNode*>::iterator i = f->begin(); i != f->end(); i++)
+	{
+		if (have_file.insert(*i).second)
+			files->push_back(*i);
+		
+		if (have_star.insert(*i).second)
+		{
+			Star* temp = new Star(*i);
+			if (!restoreStar(temp))
+				placeStar(temp,&rng);
+			stars.push_back(temp);
+		}
+	}
+}
+
+bool GSector::removeFiles(set<FileNode*>* gone)
+// Take out the stars and files that are in the given set. Returns true if the
+// sector had any of them.
+{
+	bool found = false;
+	
+	for (list<Star*>::iterator i = stars.begin(); i != stars.end();)
+	{
+		if (gone->find((*i)->getFile()) != gone->end())
+		{
+			delete *i;
+			i = stars.erase(i);
+			found = true;
+		}
+		else
+			i++;
+	}
+	
+	for (list<FileNode*>::iterator i = files->begin(); i != files->end();)
+	{
+		if (gone->find(*i) != gone->end())
+		{
+			i = files->erase(i);
+			found = true;
+		}
+		else
+			i++;
+	}
+	
+	if (found)
+		stars_changed = true;
+	
+	return found;
+}
+
+int GSector::prefetch(int max, vector<FileNode*>* read)
+// Read the metadata of up to max of the sector's files that don't have it yet
+// (zero for all of them), and update their stars. Meant to be called before
+// drawing, a batch at a time. The files read are added to read, if given.
+// Returns how many files were read.
+{
+	if (warm)
+		return 0;
+	
+	vector<FileNode*> cold;
+	vector<Star*> cold_stars;
+	
+	for (list<Star*>::iterator i = stars.begin(); i != stars.end() && (max <= 0 || (int)cold.size() < max); i++)
+		if (!(*i)->getFile()->hasType())
+		{
+			cold.push_back((*i)->getFile());
+			cold_stars.push_back(*i);
+		}
+	
+	if (cold.empty())
+	{
+		warm = true;
+		return 0;
 	}
+	
+	FileNode::prefetch(&cold);
+	
+	if (read != NULL)
+		read->insert(read->end(),cold.begin(),cold.end());
+	
+	for (size_t i = 0; i < cold_stars.size(); i++)
+		cold_stars[i]->recalc();
+	
+	stars_changed = true;
+	
+	return cold.size();
+}
+
+bool GSector::refreshFiles(set<FileNode*>* changed)
+// Update the stars of files that have changed. Returns true if the sector had
+// any of them.
+{
+	bool found = false;
+	
+	for (list<Star*>::iterator i = stars.begin(); i != stars.end(); i++)
+		if (changed->find((*i)->getFile()) != changed->end())
+		{
+			(*i)->recalc();
+			found = true;
+		}
+	
+	// Changed files need their types read again.
+	if (found)
+	{
+		warm = false;
+		stars_changed = true;
+	}
+	
+	return found;
 }
 
 list<Star*>* GSector::getStars()
@@ -90,6 +321,19 @@ list<Star*>* GSector::getStars()
 	return &stars;
 }
 
+bool GSector::starsChanged()
+// Whether any star has been added, removed, moved, or recolored since the
+// stars were last handed to the galaxy's star batch.
+{
+	return stars_changed;
+}
+
+void GSector::markStarsDrawn()
+// Note that the star batch has caught up with the stars.
+{
+	stars_changed = false;
+}
+
 float GSector::getMinStarDist(Star* s)
 {	
 	// Check if the chord length at this star's distance is long enough to
@@ -118,6 +362,8 @@ void GSector::clearStars()
 {
 	for (list<Star*>::iterator i = stars.begin(); i != stars.end(); i++)
 		delete *i;
+	
+	stars.clear();
 }
 //==============================================================================
 
@@ -132,6 +378,10 @@ float GSector::calcMinArcWidth()
 										// which will act as a chord.
 	float crd = d/radius;				// normalize the length of the chord.
 	
+	// A star wider than the whole galaxy needs half of it.
+	if (radius <= 0 || crd >= 2)
+		return 180;
+	
 	float theta = asin(crd/2)*2;
 	theta *= 180.0/M_PI;
 	
@@ -163,11 +413,48 @@ void GSector::setArcWidth(float w)
 	arc_width = w;
 }
 
+void GSector::setArc(float b, float w)
+// Move and widen the sector's arc, moving the stars with it so each stays the
+// same way across. Stars in a sector that had no width yet are left for
+// placeStrays() to find room for.
+{
+	if (arc_width > 0 && (b != arc_begin || w != arc_width))
+	{
+		for (list<Star*>::iterator i = stars.begin(); i != stars.end(); i++)
+			(*i)->setAngle(b + ((*i)->getAngle()-arc_begin)*w/arc_width);
+		
+		stars_changed = true;
+	}
+	
+	arc_begin = b;
+	arc_width = w;
+}
+
 void GSector::setThickness(float t)
 {
 	thickness = t;
 }
 
+void GSector::rescale(float r, float t)
+// Change the radius and thickness of the sector, moving the stars with it.
+{
+	float r_scale = (radius > 0) ? r/radius : 1;
+	float t_scale = (thickness > 0) ? t/thickness : 1;
+	
+	radius = r;
+	thickness = t;
+	stars_changed = true;
+	
+	for (list<Star*>::iterator i = stars.begin(); i != stars.end(); i++)
+	{
+		(*i)->setDepth((*i)->getDepth()*t_scale);
+		(*i)->setDistance((*i)->getDistance()*r_scale);
+		
+		if ((*i)->getDistance()+(*i)->getRadius() > radius)
+			(*i)->setDistance(radius-(*i)->getRadius());
+	}
+}
+
 float GSector::getRadius()
 {
 	return radius;
@@ -204,20 +491,98 @@ list<FileNode*>* GSector::getFileList()
 	return files;
 }
 
+void GSector::adoptFileList()
+// Take charge of the file list that was handed in, so it is deleted along
+// with the sector.
+{
+	own_files = true;
+}
+
 void GSector::setDirectory(DirNode* r)
-// Set the sector's root directory.
+// Set the sector's root directory, and list every file below it. The sector
+// owns the list.
 {
+	if (own_files)
+		delete files;
+	
 	root = r;
-	files = r->getAllFiles();
+	files = new list<FileNode*>;
+	own_files = true;
+	
+	for (FileIterator i(r); !i.done(); ++i)
+		files->push_back(*i);
 }
 
 DirNode* GSector::getDirectory()
-// Obtain the sector's root directory.
+// Obtain the sector's root directory. Sectors that aren't built on a single
+// directory don't have one.
 {
-	if (root == NULL) cout << "sector root is null!\n";
-	
 	return root;
 }
+
+void GSector::setMembers(list<DirNode*>* m)
+// Make the sector stand in for the given directories, and list every file
+// below them. The sector owns the list.
+{
+	if (own_files)
+		delete files;
+	
+	members = *m;
+	files = new list<FileNode*>;
+	own_files = true;
+	
+	for (list<DirNode*>::iterator i = members.begin(); i != members.end(); i++)
+		for (FileIterator j(*i); !j.done(); ++j)
+			files->push_back(*j);
+}
+
+list<DirNode*>* GSector::getMembers()
+// Obtain the directories folded into the sector.
+{
+	return &members;
+}
+
+bool GSector::isAggregate()
+{
+	return !members.empty();
+}
+
+bool GSector::removeMembers(set<DirNode*>* gone)
+// Drop directories that have left the tree from the sector's members. Their
+// files are taken out with removeFiles(). Returns true if any were dropped.
+{
+	bool found = false;
+	
+	for (list<DirNode*>::iterator i = members.begin(); i != members.end();)
+	{
+		if (gone->find(*i) != gone->end())
+		{
+			i = members.erase(i);
+			found = true;
+		}
+		else
+			i++;
+	}
+	
+	return found;
+}
+
+void GSector::addMembers(list<DirNode*>* m)
+// Fold more directories into the sector, and add stars for every file below
+// them.
+{
+	list<FileNode*> incoming;
+	
+	for (list<DirNode*>::iterator i = m->begin(); i != m->end(); i++)
+	{
+		members.push_back(*i);
+		
+		for (FileIterator j(*i); !j.done(); ++j)
+			incoming.push_back(*j);
+	}
+	
+	addFiles(&incoming);
+}
 //==============================================================================
 
 
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		20 February 2011
-// Last Updated:		17 May 2011
+// Last Updated:		18 October 2026
 //
 // File name:			Galaxy.h
 // Programmer:			Matthew Hydock
@@ -16,6 +16,111 @@
 DrawText Galaxy::starSelectionLabel(" Star Selection Mode");
 bool Galaxy::isSSLabelInitialized = false;
 
+int Galaxy::max_sectors = GALAXY_MAX_SECTORS;
+float Galaxy::min_sector_arc = GALAXY_MIN_SECTOR_ARC;
+int Galaxy::cluster_sectors = GALAXY_CLUSTER_SECTORS;
+int Galaxy::sprite_stars = GALAXY_SPRITE_STARS;
+
+//==============================================================================
+// Helpers.
+//==============================================================================
+// How big the bins are when sorting files by date.
+enum date_unit{HOURS,DAYS,MONTHS,YEARS};
+
+static long dateBin(time_t t, date_unit u)
+// Work out which bin a time goes in. Bins are counted in local time, so days
+// start at midnight and months on the first, wherever the user is.
+{
+	struct tm lt;
+	memset(&lt,0,sizeof(lt));
+	localtime_r(&t,&lt);
+	
+	switch (u)
+	{
+		case HOURS:		return (long)floor((t+lt.tm_gmtoff)/3600.0);
+		case DAYS:		return (long)floor((t+lt.tm_gmtoff)/86400.0);
+		case MONTHS:	return (lt.tm_year+1900L)*12 + lt.tm_mon;
+		default:		return lt.tm_year+1900L;
+	}
+}
+
+static string dateLabel(time_t t, date_unit u)
+// Write a time out only as precisely as the bins are.
+{
+	const char* format;
+	switch (u)
+	{
+		case HOURS:		format = "%e %b %H:00";
+						break;
+		case DAYS:		format = "%e %b %Y";
+						break;
+		case MONTHS:	format = "%b %Y";
+						break;
+		default:		format = "%Y";
+						break;
+	}
+	
+	struct tm lt;
+	memset(&lt,0,sizeof(lt));
+	localtime_r(&t,&lt);
+	
+	char buf[64];
+	strftime(buf,sizeof(buf),format,&lt);
+	
+	// Drop the padding %e puts in front of single digit days.
+	return (buf[0] == ' ') ? buf+1 : buf;
+}
+
+static int sizeBin(off_t s)
+// Work out which power of two a size is under. Empty files go in bin zero, and
+// a file of s bytes in bin k, where 2^(k-1) <= s < 2^k.
+{
+	int b = 0;
+	
+	if (s <= 0)
+		return 0;
+	
+	for (unsigned long long u = s; u > 0; u >>= 1)
+		b++;
+	
+	return b;
+}
+
+static string sizeLabel(unsigned long long s)
+// Write a size out in bytes, KB, MB, and so on, rounded down.
+{
+	const char* units[] = {"B","KB","MB","GB","TB","PB","EB"};
+	int u = 0;
+	
+	while (s >= 1024 && u < 6)
+	{
+		s /= 1024;
+		u++;
+	}
+	
+	stringstream out;
+	out << s << " " << units[u];
+	
+	return out.str();
+}
+
+static string typeLabel(enum filetype t)
+// Name a kind of file.
+{
+	switch (t)
+	{
+		case BIN:		return "binaries";
+		case APP:		return "applications";
+		case AUDIO:		return "audio";
+		case IMAGE:		return "images";
+		case TEXT:		return "text";
+		case VIDEO:		return "video";
+		default:		return "unknown";
+	}
+}
+//==============================================================================
+
+
 //==============================================================================
 // Constructors/Deconstructors
 //==============================================================================
@@ -23,6 +128,8 @@ Galaxy::Galaxy(DirNode *r, list<FileNode*>* f, cluster_type m, string n, list<st
 {
 	cout << "making a galaxy...\n";
 	
+	own_files = false;
+	
 	if (r != NULL)
 		setDirectory(r);
 	else
@@ -36,6 +143,27 @@ Galaxy::Galaxy(DirNode *r, list<FileNode*>* f, cluster_type m, string n, list<st
 	else
 		name = n;
 	
+	init(m,t);
+}
+
+Galaxy::Galaxy(list<DirNode*>* d, cluster_type m, string n)
+// Make a galaxy out of several directories at once, each one a sector, as if
+// they were the sub-directories of some directory with no files of its own.
+{
+	cout << "making a galaxy...\n";
+	
+	own_files = false;
+	
+	setMembers(d);
+	name = n;
+	
+	init(m,NULL);
+}
+
+void Galaxy::init(cluster_type m, list<string>* t)
+// Set up everything the constructors have in common, once the files are known,
+// and build the sectors.
+{
 	xPos = 0;
 	yPos = 0;
 	side = 0;
@@ -45,30 +173,32 @@ Galaxy::Galaxy(DirNode *r, list<FileNode*>* f, cluster_type m, string n, list<st
 	width = 0;
 	height = 0;
 	
-	diameter = 64.0 * pow((3.0*(double)files->size())/(4.0*M_PI),(1.0/3.0));
-	radius = diameter/2;
-	thickness = pow(radius*2.0,.5);
+	diameter = 0;
+	calcDimensions();
 	
 	setRotation(0,0);
-	setRotationSpeed(0.02);
+	setRotationSpeed(GALAXY_ROTATION_SPEED);
 	rotZ = 0;
 	
 	tags = t;
+	own_tags = false;
 	if (tags == NULL)
 		rebuildTags();
 	
 	cluster_mode = m;
 	
+	layout = NULL;
+	openLayout();
+	
 	sectors = NULL;
 	selected = NULL;
 	buildSectors();
 	
 	texture = NULL;
+	batch = new StarBatch;
+	stale_stars = 0;
 	refreshTex();
 	
-	label = NULL;
-	initLabel();
-	
 	adjustStarSelectionLabel();
 	
 	cout << "galaxy built\n";
@@ -76,6 +206,9 @@ Galaxy::Galaxy(DirNode *r, list<FileNode*>* f, cluster_type m, string n, list<st
 
 Galaxy::~Galaxy()
 {
+	saveLayout();
+	delete layout;
+	
 	for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++)
 		delete *i;
 
@@ -85,12 +218,13 @@ Galaxy::~Galaxy()
 
 //	cout << "deleted sectors list\n";
 	
-//	if (root != NULL)
-//		delete files;
+	if (own_files)
+		delete files;
 	
 //	cout << "deleted files\n";
 	
 	delete texture;
+	delete batch;
 	
 //	cout << "deleted texture\n";
 }
@@ -109,6 +243,26 @@ void Galaxy::adjustStarSelectionLabel()
 //==============================================================================
 
 
+bool Galaxy::calcDimensions()
+// Work out the size of the galaxy from the number of files in it. A galaxy with
+// no files yet (such as while indexing) is sized as if it had one. Returns
+// true if the size changed.
+{
+	double n = (files->size() > 0) ? files->size() : 1;
+	float d = 64.0 * pow((3.0*n)/(4.0*M_PI),(1.0/3.0));
+	
+	if (d == diameter)
+		return false;
+	
+	diameter = d;
+	radius = diameter/2;
+	thickness = pow(radius*2.0,.5);
+	
+	return true;
+}
+//==============================================================================
+
+
 //==============================================================================
 // Methods related to the angle and velocity of the galaxy.
 //==============================================================================
@@ -119,6 +273,7 @@ void Galaxy::setRotation(float x, float y)
 }
 
 void Galaxy::setRotationSpeed(float s)
+// Set how fast the galaxy turns, in degrees a second.
 {
 	rotSpeed = s;
 }
@@ -137,6 +292,18 @@ float Galaxy::getRotationSpeed()
 {
 	return rotSpeed;
 }
+
+bool Galaxy::animate(float dt)
+// Turn the galaxy by however far it goes in dt seconds, so it turns at the
+// same speed however often it is drawn. Returns true if it moved.
+{
+	if (rotSpeed == 0 || dt <= 0)
+		return false;
+	
+	rotZ = fmod(rotZ + rotSpeed*dt,360.0f);
+	
+	return true;
+}
 //==============================================================================
 
 
@@ -160,37 +327,34 @@ void Galaxy::setTags(list<string>* t)
 // use those.
 {
 	tags = t;
+	own_tags = false;
 }
 
 void Galaxy::rebuildTags()
-// Build the galaxy's tag list.
+// Build the galaxy's tag list from the files whose tags have already been
+// read. No tag files are read here; the rest of the tags are added as the
+// files are prefetched.
 {
-	cout << "building tags" << endl;
-	
 	// Clean out the original tags list, if it wasn't empty to begin with.
 	if (tags != NULL)	delete(tags);
 	tags = new list<string>;
+	own_tags = true;
 	
-	// Temporary list for the current file's tags.
-	list<string>* temp = NULL;
-	
-	// Go through all of the file nodes, and try to add that file's tags to the
-	// tag list. If the list already contains the current tag, skip it.
 	for (list<FileNode*>::iterator i = files->begin(); i != files->end(); i++)
-	{
-		
-		temp = (*i)->getTags();
+		if ((*i)->getKnown() & FILE_HAVE_TAGS)
+			addTags((*i)->getTags());
+}
 
-		if (temp != NULL)
-			for (list<string>::iterator j = temp->begin(); j != temp->end(); j++)
-				if (!contains(tags,*j))
-				{
-					cout << *j << endl;
-					tags->push_back(*j);
-				}
-	}
+void Galaxy::addTags(list<string>* t)
+// Add any of the given tags that the galaxy's tag list doesn't have yet, if
+// the galaxy keeps its own list.
+{
+	if (!own_tags)
+		return;
 	
-	cout << "size of tags list: " << tags->size() << endl;	
+	for (list<string>::iterator i = t->begin(); i != t->end(); i++)
+		if (!contains(tags,*i))
+			tags->push_back(*i);
 }
 
 list<string>* Galaxy::getTags()
@@ -200,9 +364,15 @@ list<string>* Galaxy::getTags()
 }
 
 void Galaxy::setClusterMode(cluster_type m)
-// Set the galaxy's clustering mode.
+// Set the galaxy's clustering mode. Each mode has a layout of its own, so the
+// current one is saved and the new mode's loaded.
 {
+	if (m == cluster_mode)
+		return;
+	
+	saveLayout();
 	cluster_mode = m;
+	openLayout();
 }
 
 cluster_type Galaxy::getClusterMode()
@@ -212,10 +382,18 @@ cluster_type Galaxy::getClusterMode()
 }
 
 void Galaxy::setDirectory(DirNode* r)
-// Set the galaxy's file indexer.
+// Set the galaxy's directory, and list every file below it. The galaxy owns
+// the list, and keeps it up to date as the tree changes.
 {
+	if (own_files)
+		delete files;
+	
 	root = r;
-	files = r->getAllFiles();
+	files = new list<FileNode*>;
+	own_files = true;
+	
+	for (FileIterator i(r); !i.done(); ++i)
+		files->push_back(*i);
 }
 
 DirNode* Galaxy::getDirectory()
@@ -224,12 +402,43 @@ DirNode* Galaxy::getDirectory()
 	return root;
 }
 
+list<DirNode*>* Galaxy::getMembers()
+// Obtain the directories the galaxy is built on, if it isn't built on just
+// one.
+{
+	return &members;
+}
+
+void Galaxy::setMembers(list<DirNode*>* d)
+// Build the galaxy on several directories, and list every file below them.
+// The galaxy owns the list.
+{
+	if (own_files)
+		delete files;
+	
+	root = NULL;
+	members = *d;
+	files = new list<FileNode*>;
+	own_files = true;
+	
+	for (list<DirNode*>::iterator i = members.begin(); i != members.end(); i++)
+		for (FileIterator j(*i); !j.done(); ++j)
+			files->push_back(*j);
+}
+
 void Galaxy::setFileList(list<FileNode*>* f)
 // Set the galaxy's file list (to be used if root == NULL)
 {
 	files = f;
 }
 
+void Galaxy::adoptFileList()
+// Take charge of the file list that was handed in, so it is deleted along
+// with the galaxy.
+{
+	own_files = true;
+}
+
 list<FileNode*>* Galaxy::getFileList()
 // Obtain the galaxy's file list (to be used if root == NULL)
 {
@@ -245,9 +454,28 @@ void Galaxy::buildSectors()
 // Build the galaxy's sectors based on the current build mode.
 {
 	cout << "building sectors\n";
+	
+	// Keep the stars where they are, if they are still in the galaxy after
+	// it has been rebuilt.
+	if (sectors != NULL && layout_matches)
+		for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++)
+			(*i)->recordLayout();
+	
 	clearSectors();
 	
 	sectors = new list<GSector*>();
+	layout_matches = true;
+	
+	// Stars are sized by their files, and some modes sort by size or date, so
+	// read any attributes the walk didn't in one batch, rather than one file
+	// at a time as they are asked for.
+	vector<FileNode*> unread;
+	for (list<FileNode*>::iterator i = files->begin(); i != files->end(); i++)
+		if (!((*i)->getKnown() & FILE_HAVE_ATTR))
+			unread.push_back(*i);
+	
+	if (!unread.empty())
+		FileNode::prefetchAttributes(&unread);
 	
 	switch (cluster_mode)
 	{
@@ -280,126 +508,547 @@ void Galaxy::buildHierarchy()
 {
 	cout << "hierarchy build mode\n";
 	
-	list<DirNode*>* dirs = root->getDirectories();
-	
-	if (root == NULL)
+	if (root == NULL && members.empty())
 	{
 		name += " [files]";
-		sectors->push_back(new GSector(NULL,files,radius,0,360,name));
+		sectors->push_back(new GSector(NULL,files,radius,0,360,name,layout));
 		return;
 	}
 	
+	list<DirNode*>* dirs = (root != NULL) ? root->getDirectories() : &members;
+	
+	float total = (files->size() > 0) ? files->size() : 1;
 	float arc_begin = 0;
-	float arc_width = 360.0*((float)root->getFiles()->size()/(float)files->size());
+	float arc_width = 0;
 	
-	// Make the sector that holds the current directories loose files.
-	sectors->push_back(new GSector(NULL,root->getFiles(),radius,arc_begin,arc_width,"./"));
-	cout << "root sector built\n";
+	// Make the sector that holds the current directories loose files. It gets
+	// its own copy of the file list, so it can be patched separately from the
+	// tree when files come and go.
+	if (root != NULL)
+	{
+		arc_width = 360.0*((float)root->getFiles()->size()/total);
+		sectors->push_back(new GSector(NULL,new list<FileNode*>(*root->getFiles()),radius,arc_begin,arc_width,"./",layout));
+		sectors->back()->adoptFileList();
+		cout << "root sector built\n";
+	}
 	
-	// Make sectors for the other subdirectories. 
+	// Make sectors for the other subdirectories, with the smallest folded
+	// into one at the end if there are too many.
 	cout << "creating sectors for directories\n";
 	
-	for (list<DirNode*>::iterator i = dirs->begin(); i != dirs->end(); i++)
+	list<DirNode*> kept;
+	list<DirNode*> folded;
+	foldDirectories(dirs,total,max_sectors-(int)sectors->size(),&kept,&folded);
+	
+	for (list<DirNode*>::iterator i = kept.begin(); i != kept.end(); i++)
 	{
 		arc_begin += arc_width;
-		arc_width = 360.0*((float)(*i)->getAllFiles()->size()/(float)files->size());
-		sectors->push_back(new GSector(*i,NULL,radius,arc_begin,arc_width));
+		arc_width = 360.0*((float)(*i)->getTotals()->files/total);
+		sectors->push_back(new GSector(*i,NULL,radius,arc_begin,arc_width,"",layout));
+	}
+	
+	if (!folded.empty())
+	{
+		int count = 0;
+		for (list<DirNode*>::iterator i = folded.begin(); i != folded.end(); i++)
+			count += (*i)->getTotals()->files;
+		
+		stringstream n;
+		n << folded.size() << " more";
+		
+		arc_begin += arc_width;
+		arc_width = 360.0*((float)count/total);
+		sectors->push_back(new GSector(&folded,radius,arc_begin,arc_width,n.str(),layout));
+	}
+}
+
+void Galaxy::foldDirectories(list<DirNode*>* dirs, float total, int limit, list<DirNode*>* kept, list<DirNode*>* folded)
+// Split the directories into those that get sectors of their own, and those
+// that are folded together. If there are more than limit, or any would get
+// less than the smallest allowed arc, the biggest are kept (leaving room for
+// the folded sector) and the rest folded. Both lists keep the directories in
+// their original order. A single directory is never folded on its own, as
+// that wouldn't save anything.
+{
+	int n = dirs->size();
+	
+	vector<pair<int,int> > sizes(n);
+	vector<DirNode*> order(dirs->begin(),dirs->end());
+	
+	bool too_small = false;
+	for (int i = 0; i < n; i++)
+	{
+		int f = order[i]->getTotals()->files;
+		sizes[i] = make_pair(-f,i);
+		
+		if (360.0*(f/total) < min_sector_arc)
+			too_small = true;
+	}
+	
+	if (n <= limit && !too_small)
+	{
+		kept->assign(order.begin(),order.end());
+		return;
+	}
+	
+	// Biggest first, and in their original order when the same size.
+	sort(sizes.begin(),sizes.end());
+	
+	vector<bool> keep(n,false);
+	for (int i = 0; i < n && i < limit-1; i++)
+		if (360.0*(-sizes[i].first/total) >= min_sector_arc)
+			keep[sizes[i].second] = true;
+	
+	for (int i = 0; i < n; i++)
+		(keep[i] ? kept : folded)->push_back(order[i]);
+	
+	if (folded->size() == 1)
+	{
+		kept->clear();
+		kept->assign(order.begin(),order.end());
+		folded->clear();
 	}
 }
 
 void Galaxy::buildByName()
-// Build a galaxy by organizing files by their names.
+// Build a galaxy by organizing files by their names. The names are folded to
+// lower case once, sorted, then split into about cluster_sectors groups at
+// points where their first few letters change.
 {
-	list<FileNode*> sorted_files;
-	list<list<FileNode*>*> file_lists;
-	size_t charindex = 0;
+	cout << "name build mode\n";
 	
-	// Sort the galaxy's file list by name of the files.
-	list<FileNode*>::iterator i = files->begin();
-	list<FileNode*>::iterator j;
-	sorted_files.push_back(*i);
-	i++;
-	while (sorted_files.size() < files->size())
+	int n = files->size();
+	
+	// Sort on the folded names. Files with the same folded name stay in the
+	// order they were in.
+	vector<pair<string,int> > keys(n);
+	vector<FileNode*> order(files->begin(),files->end());
+	
+	for (int i = 0; i < n; i++)
 	{
-		j = sorted_files.begin();
-		for(;j != sorted_files.end() && isLessThan((*j)->getName(),(*i)->getName());j++);
-		if (j == sorted_files.end())	sorted_files.push_back(*i);
-		else							sorted_files.insert(j,(*i));
-		i++;
+		string k = order[i]->getName();
+		for (size_t j = 0; j < k.size(); j++)
+			k[j] = tolower((unsigned char)k[j]);
+		
+		keys[i] = make_pair(k,i);
 	}
-	// Done sorting the sectors.
 	
-	// Preliminary test. Go through the sorted list, and see at what index do
-	// the file names start being different.
-	i = sorted_files.end();
-	string firstName = (*(sorted_files.begin()))->getName();
-	string currName = "";
+	sort(keys.begin(),keys.end());
+	
+	// Split the sorted list up.
+	vector<int> bounds;
+	vector<string> names;
+	int target = max(1,(int)ceil((float)n/max(cluster_sectors,1)));
 	
-	for (charindex = 0; i == sorted_files.end(); charindex++)
+	splitByName(&keys,0,n,0,target,&bounds,&names);
+	
+	vector<list<FileNode*>*> groups(names.size());
+	for (size_t g = 0; g < names.size(); g++)
 	{
-		for (i = sorted_files.begin(); i != sorted_files.end(); i++)
+		int begin = (g == 0) ? 0 : bounds[g-1];
+		
+		groups[g] = new list<FileNode*>;
+		for (int i = begin; i < bounds[g]; i++)
+			groups[g]->push_back(order[keys[i].second]);
+	}
+	
+	cout << "creating sectors divided by name\n";
+	addGroupSectors(&groups,&names);
+}
+
+void Galaxy::splitByName(vector<pair<string,int> >* keys, int begin, int end, size_t depth, int target, vector<int>* bounds, vector<string>* names)
+// Split a run of sorted names, which all share their first depth letters, into
+// groups of about target names. Names are taken a letter at a time; letters
+// with few names are lumped together with their neighbours, and letters with
+// far too many are split again on the letter after. The end of each group is
+// added to bounds, and a name for it (like "b", "c-f", or "ma-mo") to names.
+{
+	int group = begin;
+	int run = begin;
+	
+	while (run < end)
+	{
+		// Find the run of names with the same letter at this depth. Names
+		// that end before it sort first, and all have the same (empty) letter.
+		const string& k = (*keys)[run].first;
+		int c = (depth < k.size()) ? (unsigned char)k[depth] : -1;
+		
+		int next = run+1;
+		while (next < end)
+		{
+			const string& m = (*keys)[next].first;
+			int d = (depth < m.size()) ? (unsigned char)m[depth] : -1;
+			
+			if (d != c)
+				break;
+			next++;
+		}
+		
+		// A run that is far too big on its own is split further, unless the
+		// names in it have run out of letters.
+		if (next-run > 2*target && c != -1)
+		{
+			if (group < run)
+				addNameGroup(keys,group,run,depth,bounds,names);
+			
+			splitByName(keys,run,next,depth+1,target,bounds,names);
+			group = next;
+		}
+		// Close the current group if this run would make it too big.
+		else if (group < run && (next-group) > target + target/2)
 		{
-			currName = (*i)->getName();
-			if (charindex < currName.size() && charindex < firstName.size())
-				if (currName[charindex] != firstName[charindex])
-					break;
+			addNameGroup(keys,group,run,depth,bounds,names);
+			group = run;
 		}
+		
+		run = next;
 	}
-	// End preliminary test.
 	
-	// Begin splitting sorted list.
-	i = sorted_files.begin();
-	list<FileNode*>* temp = new list<FileNode*>;
-	temp->push_back(*i);
+	if (group < end)
+		addNameGroup(keys,group,end,depth,bounds,names);
+}
+
+void Galaxy::addNameGroup(vector<pair<string,int> >* keys, int begin, int end, size_t depth, vector<int>* bounds, vector<string>* names)
+// Note a group of sorted names that share their first depth letters, and name
+// it after the letters it covers.
+{
+	const string& first = (*keys)[begin].first;
+	const string& last = (*keys)[end-1].first;
+	
+	string a = first.substr(0,depth+1);
+	string b = last.substr(0,depth+1);
+	
+	bounds->push_back(end);
+	names->push_back((a == b) ? a : a + "-" + b);
+}
+
+void Galaxy::buildByDate()
+// Build a galaxy by sorting files into bins by when they were last modified,
+// in one pass over the files. The bins are hours, days, months, or years,
+// depending on how far apart the oldest and newest files are, and runs of
+// neighbouring bins are merged until there are about cluster_sectors of them.
+{
+	cout << "date build mode\n";
 	
-	j = i;
-	j++;
+	int n = files->size();
 	
-	string iName;
-	string jName;
-	while (j != sorted_files.end())
+	vector<FileNode*> order(files->begin(),files->end());
+	vector<time_t> times(n);
+	time_t oldest = 0;
+	time_t newest = 0;
+	
+	for (int i = 0; i < n; i++)
 	{
-		iName = (*i)->getName();
-		jName = (*j)->getName();
+		times[i] = order[i]->getModifiedTime();
 		
-		if (charindex >= jName.size() || charindex >= iName.size() || jName[charindex] != iName[charindex])
-		{
-			file_lists.push_back(temp);
-			temp = new list<FileNode*>;
-		}
+		if (i == 0 || times[i] < oldest)	oldest = times[i];
+		if (i == 0 || times[i] > newest)	newest = times[i];
+	}
+	
+	// Pick the size of the bins.
+	double span = difftime(newest,oldest);
+	date_unit unit;
+	
+	if (span <= 2*86400.0)				unit = HOURS;
+	else if (span <= 92*86400.0)		unit = DAYS;
+	else if (span <= 10*366*86400.0)	unit = MONTHS;
+	else								unit = YEARS;
+	
+	// Count the files in each bin, keeping track of the oldest and newest time
+	// in each, to name the sectors after.
+	vector<int> bins(n);
+	long first = dateBin(oldest,unit);
+	long last = dateBin(newest,unit);
+	
+	if (last-first >= GALAXY_DATE_MAX_BINS)
+		first = last-GALAXY_DATE_MAX_BINS+1;
+	
+	int num_bins = last-first+1;
+	vector<int> counts(num_bins,0);
+	vector<time_t> bin_oldest(num_bins,0);
+	vector<time_t> bin_newest(num_bins,0);
+	
+	for (int i = 0; i < n; i++)
+	{
+		long b = max(dateBin(times[i],unit),first)-first;
+		bins[i] = b;
 		
-		temp->push_back(*j);
-		i = j;
-		j++;
+		if (counts[b] == 0 || times[i] < bin_oldest[b])	bin_oldest[b] = times[i];
+		if (counts[b] == 0 || times[i] > bin_newest[b])	bin_newest[b] = times[i];
+		counts[b]++;
 	}
 	
-	file_lists.push_back(temp);
-	// End splitting sorted list.
+	// Merge the bins, and sort the files into the merged groups.
+	vector<int> group_of;
+	int num_groups = groupBins(&counts,cluster_sectors,&group_of);
 	
-	// Start making the sectors.
-	float arc_begin = 0;
-	float arc_width = 0;
-	 
-	cout << "creating sectors divided by name\n";
-	for (list<list<FileNode*>*>::iterator i = file_lists.begin(); i != file_lists.end(); i++)
+	vector<list<FileNode*>*> groups(num_groups);
+	vector<time_t> group_oldest(num_groups,0);
+	vector<time_t> group_newest(num_groups,0);
+	
+	for (int g = 0; g < num_groups; g++)
+		groups[g] = new list<FileNode*>;
+	
+	// Groups are runs of bins, so a group's oldest time is in its first bin,
+	// and its newest in its last.
+	int prev = -1;
+	for (int b = 0; b < num_bins; b++)
 	{
-		string name = (*((*i)->begin()))->getName();
-		name = name.substr(0,charindex);
-		arc_begin += arc_width;
-		arc_width = 360.0*((float)(*i)->size()/(float)sorted_files.size());
-		sectors->push_back(new GSector(NULL,(*i),radius,arc_begin,arc_width,name));
+		int g = group_of[b];
+		if (g < 0)
+			continue;
+		
+		if (g != prev)
+			group_oldest[g] = bin_oldest[b];
+		group_newest[g] = bin_newest[b];
+		prev = g;
 	}
-	// End making sectors.
+	
+	for (int i = 0; i < n; i++)
+		groups[group_of[bins[i]]]->push_back(order[i]);
+	
+	vector<string> labels(num_groups);
+	for (int g = 0; g < num_groups; g++)
+	{
+		string a = dateLabel(group_oldest[g],unit);
+		string b = dateLabel(group_newest[g],unit);
+		
+		labels[g] = (a == b) ? a : a + " - " + b;
+	}
+	
+	cout << "creating sectors divided by date\n";
+	addGroupSectors(&groups,&labels);
 }
 
-void Galaxy::buildByDate()
-{}
+int Galaxy::groupBins(vector<int>* counts, int target, vector<int>* groups)
+// Merge runs of neighbouring bins into about target groups of about the same
+// size, in one pass. Empty bins are skipped, and a bin is never split, so one
+// very full bin makes a group of its own. For each bin, groups gets the group
+// it went in (or -1 if it was empty). Returns the number of groups.
+{
+	int total = 0;
+	for (size_t b = 0; b < counts->size(); b++)
+		total += (*counts)[b];
+	
+	int size = max(1,(int)ceil((float)total/max(target,1)));
+	
+	int g = -1;
+	int in_group = 0;
+	
+	groups->assign(counts->size(),-1);
+	
+	for (size_t b = 0; b < counts->size(); b++)
+	{
+		int c = (*counts)[b];
+		if (c == 0)
+			continue;
+		
+		// Start a new group if this is the first bin, or it would make the
+		// current group too big.
+		if (g < 0 || in_group + c > size + size/2)
+		{
+			g++;
+			in_group = 0;
+		}
+		
+		(*groups)[b] = g;
+		in_group += c;
+	}
+	
+	return g+1;
+}
 
 void Galaxy::buildBySize()
-{}
+// Build a galaxy by sorting files into bins by the power of two their sizes
+// are under, in one pass over the files. The bins are then merged into about
+// cluster_sectors groups with about as many files in each, so the edges
+// between sectors follow how the sizes are spread out, and no sector is empty.
+{
+	cout << "size build mode\n";
+	
+	int n = files->size();
+	
+	// A bin number for each file, and a count for each bin. Sizes are no
+	// more than 64 bits, so there are at most 65 bins.
+	vector<unsigned char> bins(n);
+	vector<int> counts(65,0);
+	
+	int k = 0;
+	for (list<FileNode*>::iterator i = files->begin(); i != files->end(); i++, k++)
+	{
+		bins[k] = sizeBin((*i)->getSize());
+		counts[bins[k]]++;
+	}
+	
+	// Merge the bins, and sort the files into the merged groups.
+	vector<int> group_of;
+	int num_groups = groupBins(&counts,cluster_sectors,&group_of);
+	
+	vector<list<FileNode*>*> groups(num_groups);
+	vector<int> group_first(num_groups,-1);
+	vector<int> group_last(num_groups,-1);
+	
+	for (int g = 0; g < num_groups; g++)
+		groups[g] = new list<FileNode*>;
+	
+	for (int b = 0; b < 65; b++)
+	{
+		int g = group_of[b];
+		if (g < 0)
+			continue;
+		
+		if (group_first[g] < 0)
+			group_first[g] = b;
+		group_last[g] = b;
+	}
+	
+	k = 0;
+	for (list<FileNode*>::iterator i = files->begin(); i != files->end(); i++, k++)
+		groups[group_of[bins[k]]]->push_back(*i);
+	
+	vector<string> labels(num_groups);
+	for (int g = 0; g < num_groups; g++)
+	{
+		// The smallest size in the group's first bin, and the size every
+		// file in its last bin is under.
+		unsigned long long low = (group_first[g] == 0) ? 0 : 1ULL << (group_first[g]-1);
+		unsigned long long high = (group_last[g] >= 64) ? 0 : 1ULL << group_last[g];
+		
+		if (num_groups == 1)
+			labels[g] = "all sizes";
+		else if (g == 0)
+			labels[g] = "< " + sizeLabel(high);
+		else if (g == num_groups-1)
+			labels[g] = ">= " + sizeLabel(low);
+		else
+			labels[g] = sizeLabel(low) + " - " + sizeLabel(high);
+	}
+	
+	cout << "creating sectors divided by size\n";
+	addGroupSectors(&groups,&labels);
+}
 
 void Galaxy::buildByType()
-{}
+// Build a galaxy by sorting files by their types, with a counting sort. Files
+// are counted by full mime-type in one pass, and each kind of file (image,
+// text, and so on) is a sector, except those with far more than their share
+// of files, which are split up by mime-type. The biggest mime-types get their
+// own sectors, and the rest share one.
+{
+	cout << "type build mode\n";
+	
+	int n = files->size();
+	
+	// Work out the types of any files that don't have them yet all at once,
+	// rather than one at a time as they are counted.
+	vector<FileNode*> untyped;
+	for (list<FileNode*>::iterator i = files->begin(); i != files->end(); i++)
+		if (!(*i)->hasType())
+			untyped.push_back(*i);
+	
+	if (!untyped.empty())
+		FileNode::prefetch(&untyped);
+	
+	for (size_t i = 0; i < untyped.size(); i++)
+		addTags(untyped[i]->getTags());
+	
+	// Number each mime-type as it turns up, and count the files of each.
+	// Mime-types are shared between files, so they are told apart by their
+	// addresses.
+	tr1::unordered_map<const string*,int> numbers;
+	vector<const string*> mimes;
+	vector<int> mime_counts;
+	vector<int> mime_kinds;
+	vector<int> kind_counts(UNKNOWN+1,0);
+	vector<int> mime_of(n);
+	
+	int k = 0;
+	for (list<FileNode*>::iterator i = files->begin(); i != files->end(); i++, k++)
+	{
+		const string* m = (*i)->getSharedMimetype();
+		tr1::unordered_map<const string*,int>::iterator f = numbers.find(m);
+		
+		if (f == numbers.end())
+		{
+			f = numbers.insert(make_pair(m,(int)mimes.size())).first;
+			mimes.push_back(m);
+			mime_counts.push_back(0);
+			mime_kinds.push_back((*i)->getMimeEnum());
+		}
+		
+		mime_of[k] = f->second;
+		mime_counts[f->second]++;
+		kind_counts[mime_kinds[f->second]]++;
+	}
+	
+	// Work out the groups. Each kind of file gets one, unless it is to be
+	// split, in which case its biggest mime-types get one each, and the rest
+	// share one.
+	float share = (float)n/max(cluster_sectors,1);
+	
+	vector<int> group_of(mimes.size(),-1);
+	vector<string> labels;
+	
+	for (int t = 0; t <= UNKNOWN; t++)
+	{
+		if (kind_counts[t] == 0)
+			continue;
+		
+		vector<pair<int,int> > kind_mimes;
+		for (size_t m = 0; m < mimes.size(); m++)
+			if (mime_kinds[m] == t)
+				kind_mimes.push_back(make_pair(-mime_counts[m],m));
+		
+		if (kind_counts[t] <= GALAXY_TYPE_SPLIT*share || kind_mimes.size() == 1)
+		{
+			for (size_t m = 0; m < kind_mimes.size(); m++)
+				group_of[kind_mimes[m].second] = labels.size();
+			labels.push_back(typeLabel((enum filetype)t));
+			continue;
+		}
+		
+		// Biggest first, and in the order they turned up when the same size.
+		// Mime-types with only a few files aren't worth a sector of their own.
+		sort(kind_mimes.begin(),kind_mimes.end());
+		
+		int keep = max(2,(int)(kind_counts[t]/share));
+		int rest = -1;
+		
+		for (size_t m = 0; m < kind_mimes.size(); m++)
+		{
+			int mime = kind_mimes[m].second;
+			bool big = (int)m < keep && mime_counts[mime] >= share/4;
+			
+			// A lone mime-type left over doesn't need a sector to share.
+			if (big || (kind_mimes.size() == m+1 && rest < 0))
+			{
+				group_of[mime] = labels.size();
+				labels.push_back(*mimes[mime]);
+			}
+			else
+			{
+				if (rest < 0)
+				{
+					rest = labels.size();
+					labels.push_back("other " + typeLabel((enum filetype)t));
+				}
+				group_of[mime] = rest;
+			}
+		}
+	}
+	
+	// Sort the files into their groups.
+	vector<list<FileNode*>*> groups(labels.size());
+	for (size_t g = 0; g < groups.size(); g++)
+		groups[g] = new list<FileNode*>;
+	
+	k = 0;
+	for (list<FileNode*>::iterator i = files->begin(); i != files->end(); i++, k++)
+		groups[group_of[mime_of[k]]]->push_back(*i);
+	
+	cout << "creating sectors divided by type\n";
+	addGroupSectors(&groups,&labels);
+}
 
 void Galaxy::buildByTags()
 // Build sectors by separating files according to what tags they have.
@@ -407,6 +1056,12 @@ void Galaxy::buildByTags()
 	list<list<FileNode*>*>* temp_list = new list<list<FileNode*>*>;
 	int total_size = 0;
 	
+	// Sorting by the galaxy's own tags needs every file's tags, so any that
+	// haven't been read are read now.
+	if (own_tags)
+		for (list<FileNode*>::iterator i = files->begin(); i != files->end(); i++)
+			addTags((*i)->getTags());
+	
 	// Make a file list for each tag, containing files that have those tags.
 	for (list<string>::iterator i = tags->begin(); i != tags->end(); i++)
 	{
@@ -439,13 +1094,48 @@ void Galaxy::buildByTags()
 	{
 		arc_begin += arc_width;
 		arc_width = 360.0*((float)(*i)->size()/total_size);
-		sectors->push_back(new GSector(NULL,*i,radius,arc_begin,arc_width,*n));
+		sectors->push_back(new GSector(NULL,*i,radius,arc_begin,arc_width,*n,layout));
 		n++;
 	}
 
 	if (sectors->size() <= 1)
 		rebuildTags();
 }
+
+void Galaxy::addGroupSectors(vector<list<FileNode*>*>* groups, vector<string>* labels)
+// Make a sector for each group of files, named after its label, and lay them
+// out end to end with arcs in proportion to how many files they have. The
+// sectors take charge of the groups' lists. If there are no files at all, the
+// galaxy gets one sector for the whole circle instead.
+{
+	int n = 0;
+	for (size_t g = 0; g < groups->size(); g++)
+		n += (*groups)[g]->size();
+	
+	if (n == 0)
+	{
+		for (size_t g = 0; g < groups->size(); g++)
+			delete (*groups)[g];
+		
+		sectors->push_back(new GSector(NULL,files,radius,0,360,name,layout));
+		return;
+	}
+	
+	// Start making the sectors.
+	float arc_begin = 0;
+	float arc_width = 0;
+	
+	for (size_t g = 0; g < groups->size(); g++)
+	{
+		arc_begin += arc_width;
+		arc_width = 360.0*((float)(*groups)[g]->size()/n);
+		
+		GSector* temp = new GSector(NULL,(*groups)[g],radius,arc_begin,arc_width,(*labels)[g],layout);
+		temp->adoptFileList();
+		sectors->push_back(temp);
+	}
+	// End making sectors.
+}
 //==============================================================================
 
 
@@ -453,79 +1143,171 @@ void Galaxy::buildByTags()
 // Sector management.
 //==============================================================================
 void Galaxy::adjustSectorWidths()
-// Dynamically resize the sectors' widths, in case some are too small. This
-// method will probably derp hard if there are a ton of sectors that are too
-// small. Until I fix that, just try not to have ~90 directories with only 1
-// file in each of them.
-{	
-	list<GSector*> *temp = new list<GSector*>();
-	list<GSector*>::iterator i = sectors->begin();
-	list<GSector*>::iterator j;
-	
-	// Sort the sectors into another list.
-	temp->push_back(*i);
-	i++;
-	while (temp->size() < sectors->size())
-	{
-		j = temp->begin();
-		while(j != temp->end() && (*i)->getArcWidth() > (*j)->getArcWidth())
-			j++;
-		if (j == temp->end())	temp->push_back(*i);
-		else					temp->insert(j,(*i));
-		i++;
-	}
-	// Done sorting the sectors.
-		
-	// If the current sector is too small, grow it and shrink all larger ones.
-	for (i = temp->begin(); i != temp->end() && (*i)->getArcWidth() < ((*i)->calcMinArcWidth()+4); i++)
-	{
-		float diff = ((*i)->calcMinArcWidth()+4)-(*i)->getArcWidth();
-		(*i)->setArcWidth((*i)->getArcWidth()+diff);
-		
-		int remain = 0;
-		for (j = i; j != temp->end(); j++)
-			remain++;
-		remain--;
-		
-		float distr = diff/(float)remain;
-		
-		j = i;
-		j++;
-		while (j != temp->end())
-		{
-			(*j)->setArcWidth((*j)->getArcWidth()-distr);
-			j++;
-		}
+// Resize the sectors' widths so none is too small to hold its biggest star,
+// sharing out the rest of the circle in proportion to their current widths,
+// then line them up end to end.
+{
+	if (sectors->empty())
+		return;
+	
+	vector<GSector*> order(sectors->begin(),sectors->end());
+	vector<float> widths(order.size());
+	vector<float> floors(order.size());
+	
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		widths[i] = max(order[i]->getArcWidth(),0.0f);
+		floors[i] = order[i]->calcMinArcWidth()+GALAXY_SECTOR_PADDING;
 	}
-	// Done shrinking the sectors.
 	
-	// Shift all of the sectors into proper positions
-	i = sectors->begin();
-	j = sectors->begin();
+	fitArcWidths(&widths,&floors,360);
 	
-	j++;
-	for(;j != sectors->end(); j++)
+	float arc_begin = order[0]->getArcBegin();
+	for (size_t i = 0; i < order.size(); i++)
 	{
-		(*j)->setArcBegin((*i)->getArcEnd());
-		i = j;
+		order[i]->setArc(arc_begin,widths[i]);
+		arc_begin += widths[i];
 	}
-	// Done shifting sectors.
 	
 	// Make sure all the stars are within their sector's bounds.
-	for (i = sectors->begin(); i != sectors->end(); i++)
+	for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++)
+		(*i)->placeStrays();
+	// Done repositioning stars.
+}
+
+void Galaxy::fitArcWidths(vector<float>* widths, vector<float>* floors, float total)
+// Share total degrees out in proportion to the given widths, without giving
+// anything less than its floor. If every width is scaled by s, the ones whose
+// floor is more than s times their width are held at their floors, and the
+// rest are scaled to fill what is left. Sorting by that ratio means s can be
+// found in one pass. If even the floors don't fit, they are all shrunk to fit
+// instead.
+{
+	int n = widths->size();
+	double floor_sum = 0;
+	double width_sum = 0;
+	
+	if (n == 0)
+		return;
+	
+	for (int i = 0; i < n; i++)
 	{
-		float beg = (*i)->getArcBegin();
-		float wid = (*i)->getArcWidth();
-		float thk = (*i)->getThickness();
-		float rad = (*i)->getRadius();
+		floor_sum += (*floors)[i];
+		width_sum += (*widths)[i];
+	}
+	
+	if (floor_sum >= total || width_sum <= 0)
+	{
+		for (int i = 0; i < n; i++)
+			(*widths)[i] = (floor_sum > 0) ? (*floors)[i]*(total/floor_sum) : total/n;
+		return;
+	}
+	
+	// How many times its width each sector needs to reach its floor. Empty
+	// sectors can only ever have their floors.
+	vector<pair<double,int> > ratios(n);
+	for (int i = 0; i < n; i++)
+		ratios[i] = make_pair(((*widths)[i] > 0) ? (*floors)[i]/(*widths)[i] : HUGE_VAL,i);
+	
+	sort(ratios.begin(),ratios.end());
+	
+	// Hold sectors at their floors, neediest first, until the rest fit when
+	// scaled. Each one held makes the scale smaller, so the first one that
+	// fits means all the rest do too.
+	double fixed = 0;
+	double rest = width_sum;
+	double scale = total/width_sum;
+	int k = n;
+	
+	while (k > 0)
+	{
+		scale = (rest > 0) ? (total-fixed)/rest : 0;
+		
+		if (ratios[k-1].first <= scale)
+			break;
 		
-		for (list<Star*>::iterator k = (*i)->getStars()->begin(); k != (*i)->getStars()->end(); k++)
-			if ((*k)->getAngle() > beg+wid || (*k)->getAngle() < beg)
-				(*k)->randomPosition(beg,beg+wid,0,rad,-thk,thk);
+		k--;
+		fixed += (*floors)[ratios[k].second];
+		rest -= (*widths)[ratios[k].second];
 	}
-	// Done repositioning stars.
+	
+	for (int i = 0; i < k; i++)
+		(*widths)[ratios[i].second] *= scale;
+	
+	for (int i = k; i < n; i++)
+		(*widths)[ratios[i].second] = (*floors)[ratios[i].second];
+}
+
+void Galaxy::resizeSectors()
+// Set the sectors' widths in proportion to how many files they have, after
+// files have been added or removed, then fix up any that are too small.
+{
+	float total = 0;
+	for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++)
+		total += (*i)->getFileList()->size();
+	
+	if (sectors->empty() || total == 0)
+		return;
+	
+	float arc_begin = 0;
+	for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++)
+	{
+		(*i)->setArc(arc_begin,360.0*((float)(*i)->getFileList()->size()/total));
+		(*i)->setSingleSectorMode(sectors->size() == 1);
+		arc_begin += (*i)->getArcWidth();
+	}
+	
+	if (sectors->size() > 1)
+		adjustSectorWidths();
+}
+
+void Galaxy::setSectorLimits(int n, float a)
+// Set the most sectors a galaxy built on directories can have, and the
+// smallest arc (in degrees) a directory can have a sector of its own with.
+// Anything past either is folded into one sector. There must be room for at
+// least two sectors.
+{
+	max_sectors = max(n,2);
+	min_sector_arc = max(a,0.0f);
+}
+
+void Galaxy::setClusterSectors(int n)
+// Set how many sectors to aim for when splitting files up by name, date, and
+// so on.
+{
+	cluster_sectors = max(n,1);
+}
+
+void Galaxy::setSpriteStars(int n)
+// Set how many stars a galaxy can have before they are drawn as point sprites.
+{
+	sprite_stars = max(n,0);
+}
+
+void Galaxy::openLayout()
+// Load where the stars were placed the last time this galaxy was shown in the
+// current clustering mode. Galaxies without a directory go by their names.
+{
+	delete layout;
+	
+	layout = new StarLayout(StarLayout::pathFor((root != NULL) ? root->getPath() : name,cluster_mode));
+	layout->load();
+	
+	// Whatever sectors there are were built some other way.
+	layout_matches = false;
+}
+
+void Galaxy::saveLayout()
+// Record where every star is, and save it for next time.
+{
+	if (layout == NULL || sectors == NULL || !layout_matches)
+		return;
+	
+	for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++)
+		(*i)->recordLayout();
+	
+	layout->save();
 }
-		
 
 void Galaxy::clearSectors()
 {
@@ -543,6 +1325,270 @@ list<GSector*>* Galaxy::getSectors()
 {
 	return sectors;
 }
+
+DirNode* Galaxy::topDirectory(FileNode* f)
+// Find which of the galaxy's top directories the given file is under: one of
+// the root's sub-directories, or one of the members of a galaxy built on
+// several. Gives the root itself for the root's own files, and NULL for files
+// that aren't in the galaxy at all.
+{
+	DirNode* d = (DirNode*)f->getParent();
+	
+	if (root == NULL)
+	{
+		while (d != NULL && find(members.begin(),members.end(),d) == members.end())
+			d = d->getParent();
+		
+		return d;
+	}
+	
+	if (d == root)
+		return root;
+	
+	while (d != NULL && d->getParent() != root)
+		d = d->getParent();
+	
+	return d;
+}
+
+void Galaxy::mapDirectories(map<DirNode*,GSector*>* m)
+// Work out which sector each of the root's sub-directories is shown in. The
+// directories folded together all map to the sector they were folded into.
+{
+	for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++)
+	{
+		if ((*i)->isAggregate())
+		{
+			list<DirNode*>* dl = (*i)->getMembers();
+			for (list<DirNode*>::iterator j = dl->begin(); j != dl->end(); j++)
+				(*m)[*j] = *i;
+		}
+		else if ((*i)->getDirectory() != NULL)
+			(*m)[(*i)->getDirectory()] = *i;
+	}
+}
+
+bool Galaxy::applyChanges(TreeChanges* c)
+// Patch the galaxy after the directory tree has changed. Only the sectors that
+// had files come, go, or change are touched, and the rest keep their stars
+// where they are. New files only join galaxies that are built on directories,
+// as the others are made from a fixed list of files. Returns false if the
+// galaxy's directory is gone, in which case it should be thrown away.
+{
+	if (root != NULL && c->isRemoved(root))
+		return false;
+	
+	// A galaxy built on several directories goes once all of them have.
+	if (!members.empty())
+	{
+		for (list<DirNode*>::iterator i = members.begin(); i != members.end();)
+		{
+			if (c->isRemoved(*i))
+				i = members.erase(i);
+			else
+				i++;
+		}
+		
+		if (members.empty())
+			return false;
+	}
+	
+	bool touched = false;
+	bool rebuild = false;
+	
+	// Take out files that are gone, and sectors for directories that are gone.
+	if (!c->getRemoved()->empty() || !c->getRemovedDirectories()->empty())
+	{
+		for (list<FileNode*>::iterator i = files->begin(); i != files->end();)
+		{
+			if (c->isRemoved(*i))
+				i = files->erase(i);
+			else
+				i++;
+		}
+		
+		for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end();)
+		{
+			if ((*i)->isAggregate())
+				(*i)->removeMembers(c->getRemovedDirectories());
+			
+			bool gone;
+			if ((*i)->isAggregate())
+				gone = (*i)->getMembers()->empty();
+			else
+				gone = (*i)->getDirectory() != NULL && c->isRemoved((*i)->getDirectory());
+			
+			if (cluster_mode == DIRECTORY && gone)
+			{
+				if (selected == *i)
+					selected = NULL;
+				
+				delete *i;
+				i = sectors->erase(i);
+				touched = true;
+				continue;
+			}
+			
+			if ((*i)->removeFiles(c->getRemoved()))
+				touched = true;
+			i++;
+		}
+	}
+	
+	// Update the stars of files that changed.
+	if (!c->getChanged()->empty())
+	{
+		set<FileNode*> changed(c->getChanged()->begin(),c->getChanged()->end());
+		
+		for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++)
+			if ((*i)->refreshFiles(&changed))
+				touched = true;
+	}
+	
+	// Make sectors for new directories, then sort new files into the sectors
+	// they belong to. A sector for a new directory is built with whatever is
+	// in the directory already, so those files are skipped when they come up.
+	// Only the directory build mode knows where a new file goes; galaxies
+	// built other ways are rebuilt instead.
+	if (root != NULL && cluster_mode == DIRECTORY && !c->getAddedDirectories()->empty())
+	{
+		map<DirNode*,GSector*> by_dir;
+		mapDirectories(&by_dir);
+		
+		GSector* folded = NULL;
+		for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++)
+			if ((*i)->isAggregate())
+				folded = *i;
+		
+		// Once the galaxy is full (keeping the last place for a folded
+		// sector), new directories are folded in with the rest, rather than
+		// the whole galaxy being rebuilt every time one turns up. They are
+		// only sorted out again when the galaxy is next rebuilt.
+		list<DirNode*> overflow;
+		
+		list<DirNode*>* dl = c->getAddedDirectories();
+		for (list<DirNode*>::iterator i = dl->begin(); i != dl->end(); i++)
+		{
+			if ((*i)->getParent() != root || by_dir.find(*i) != by_dir.end())
+				continue;
+			
+			if (folded == NULL && (int)sectors->size()+1 < max_sectors)
+				sectors->push_back(new GSector(*i,NULL,radius,0,0,"",layout));
+			else
+				overflow.push_back(*i);
+			
+			touched = true;
+		}
+		
+		if (!overflow.empty())
+		{
+			if (folded == NULL)
+			{
+				folded = new GSector(&overflow,radius,0,0,"",layout);
+				sectors->push_back(folded);
+			}
+			else
+				folded->addMembers(&overflow);
+			
+			stringstream n;
+			n << folded->getMembers()->size() << " more";
+			folded->setName(n.str());
+		}
+	}
+	
+	if ((root != NULL || !members.empty()) && !c->getAdded()->empty())
+	{
+		map<DirNode*,GSector*> by_dir;
+		if (cluster_mode == DIRECTORY)
+			mapDirectories(&by_dir);
+		
+		map<GSector*,list<FileNode*> > incoming;
+		
+		for (list<FileNode*>::iterator i = c->getAdded()->begin(); i != c->getAdded()->end(); i++)
+		{
+			DirNode* top = topDirectory(*i);
+			
+			if (top == NULL)
+				continue;
+			
+			files->push_back(*i);
+			
+			if (cluster_mode != DIRECTORY)
+			{
+				rebuild = true;
+				continue;
+			}
+			
+			if (top == root)
+			{
+				incoming[sectors->front()].push_back(*i);
+				continue;
+			}
+			
+			if (by_dir.find(top) != by_dir.end())
+				incoming[by_dir[top]].push_back(*i);
+		}
+		
+		for (map<GSector*,list<FileNode*> >::iterator i = incoming.begin(); i != incoming.end(); i++)
+			i->first->addFiles(&i->second);
+		
+		if (!incoming.empty())
+			touched = true;
+	}
+	
+	if (rebuild)
+	{
+		selected = NULL;
+		buildSectors();
+		refreshTex();
+	}
+	else if (touched)
+	{
+		// The galaxy grows or shrinks with the number of files in it. The
+		// stars keep their places, relative to the new size.
+		if (calcDimensions())
+			for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++)
+				(*i)->rescale(radius,thickness);
+		
+		resizeSectors();
+		refreshTex();
+	}
+	
+	return true;
+}
+//==============================================================================
+
+
+int Galaxy::prefetch(int max)
+// Read the metadata for up to max more of the galaxy's files, so their stars
+// can be drawn properly. The sector under the mouse goes first, then the rest
+// in order. The texture is only redrawn every GALAXY_PREFETCH_REDRAW stars, or
+// once everything has been read, so it isn't redrawn for every batch. Returns
+// how many files were read.
+{
+	int done = 0;
+	vector<FileNode*> read;
+	
+	if (selected != NULL)
+		done += selected->prefetch(max,&read);
+	
+	for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end() && done < max; i++)
+		done += (*i)->prefetch(max-done,&read);
+	
+	// The files just read have their tags, so the tag list can take them in.
+	for (size_t i = 0; i < read.size(); i++)
+		addTags(read[i]->getTags());
+	
+	stale_stars += done;
+	
+	if (stale_stars >= GALAXY_PREFETCH_REDRAW || (done == 0 && stale_stars > 0))
+	{
+		refreshTex();
+		stale_stars = 0;
+	}
+	
+	return done;
+}
 //==============================================================================
 
 
@@ -597,7 +1643,9 @@ GSector* Galaxy::getSelected()
 // Methods related to drawing.
 //==============================================================================
 void Galaxy::refreshTex()
-// Update the galaxy texture.
+// Update the galaxy texture. The star batch is only packed again if the stars
+// have changed since it was last drawn. Galaxies with too many stars to draw
+// as quads are drawn as point sprites.
 {
 	int tex_size;
 	tex_size = (int)(1024.0 * (diameter/500.0));
@@ -626,13 +1674,13 @@ void Galaxy::refreshTex()
 		glLoadIdentity();
 		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
-//		if (files->size() > 200)
-//			Star::setPointDrawMode();
-//		else
-//			Star::setTexturedDrawMode();
+		if ((int)files->size() > sprite_stars)
+			Star::setPointDrawMode();
+		else
+			Star::setTexturedDrawMode();
 
-		for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++)
-			(*i)->draw();
+		batch->update(sectors);
+		batch->draw(tex_size/diameter);
 			
 		glFlush();
 	glPopAttrib();
@@ -673,9 +1721,8 @@ void Galaxy::drawNormalMode()
 			selected->drawMask();
 		glPopMatrix();
 		
-		// Try to initialize the text label. If it already exists, this does
-		// nothing.
-		selected->initLabel();
+		// Get the sector's label from the label cache.
+		DrawText* label = selected->getLabel();
 		
 		float angle = rotZ + selected->getArcBegin() + (selected->getArcWidth()/2);			
 		float x = ((side-5)/4) * cos(angle*M_PI/180);
@@ -683,9 +1730,11 @@ void Galaxy::drawNormalMode()
 	
 //		cout << angle << " " << x << " " << y << endl;
 			
+		label->setPosition(x,y);
+		
 		glPushMatrix();
-			glTranslatef(x,y,3);
-			selected->drawLabel();
+			glTranslatef(0,0,3);
+			label->draw();
 		glPopMatrix();
 	}
 	// Done drawing selection mask.
@@ -727,9 +1776,8 @@ void Galaxy::drawStarSelectionMode()
 			{
 				//cout << "User is mousing over star " << star->getName() << endl;
 				
-				// Try to initialize the text label. If it already exists,
-				// this does nothing.
-				star->initLabel();
+				// Get the star's label from the label cache.
+				DrawText* label = star->getLabel();
 				
 				// Galaxy is being scaled to window. The star's label's
 				// coordinates also need to be scaled, if they are to hover
@@ -739,8 +1787,8 @@ void Galaxy::drawStarSelectionMode()
 				
 				float x = d*cos(a*M_PI/180);
 				float y = d*sin(a*M_PI/180);
-				float w = star->getLabel()->getWidth();
-				float h = star->getLabel()->getHeight();
+				float w = label->getWidth();
+				float h = label->getHeight();
 				
 				x *= ((side-5)/2)/radius;
 				y *= ((side-5)/2)/radius;
@@ -752,12 +1800,12 @@ void Galaxy::drawStarSelectionMode()
 				if (y+h/2 > height/2.0) y = height/2.0 - h/2;					
 						
 				// Set the label's new position.
-				star->getLabel()->setPosition(x,y);
+				label->setPosition(x,y);
 				
 				// Shift the label up a little, and draw.
 				glPushMatrix();
 					glTranslatef(0,0,2);
-					star->drawLabel();
+					label->draw();
 				glPopMatrix();
 			}
 		}
@@ -817,8 +1865,5 @@ void Galaxy::draw()
 			
 	// Turn off blending.
 	glDisable(GL_BLEND);
-	
-	rotZ += rotSpeed;
-		if (rotZ > 360) rotZ -= 360;
 }
 //==============================================================================
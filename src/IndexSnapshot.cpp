@@ -0,0 +1,489 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			IndexSnapshot.cpp
+// Programmer:			Matthew Hydock
+//
+// File description:	Saves a directory tree to a compact binary file, and
+//						maps it back in on the next start. Directories are only
+//						turned back into nodes when something looks inside them.
+//==============================================================================
+
+#include "IndexSnapshot.h"
+
+#include <map>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+//==============================================================================
+// Constructor/Deconstructor
+//==============================================================================
+IndexSnapshot::IndexSnapshot(string p)
+// Make a snapshot object for the given file. Nothing is read until load().
+{
+	path = p;
+
+	mapping = NULL;
+	map_size = 0;
+	header = NULL;
+	dirs = NULL;
+	files = NULL;
+	strings = NULL;
+}
+
+IndexSnapshot::~IndexSnapshot()
+{
+	unload();
+}
+//==============================================================================
+
+
+//==============================================================================
+// Private methods.
+//==============================================================================
+const char* IndexSnapshot::getString(uint32_t offset)
+// Get a string out of the string block. Offsets past the end of the block give
+// the empty string.
+{
+	if (offset >= header->strings_size)
+		return strings;
+	
+	return strings + offset;
+}
+
+bool IndexSnapshot::validate()
+// Make sure the mapped file is a snapshot this version can read, and that none
+// of its sections run off the end of the file.
+{
+	if (map_size < sizeof(SnapshotHeader))
+		return false;
+
+	if (memcmp(header->magic,SNAPSHOT_MAGIC,sizeof(header->magic)) != 0 || header->version != SNAPSHOT_VERSION)
+		return false;
+
+	if (header->num_dirs == 0)
+		return false;
+
+	if (header->dirs_offset + (uint64_t)header->num_dirs*sizeof(SnapshotDir) > map_size)
+		return false;
+
+	if (header->files_offset + (uint64_t)header->num_files*sizeof(SnapshotFile) > map_size)
+		return false;
+
+	if (header->strings_offset + header->strings_size > map_size || header->strings_size == 0)
+		return false;
+
+	// The string block must end with a terminator, so no string can run off
+	// the end of it.
+	if (((const char*)mapping)[header->strings_offset + header->strings_size - 1] != '\0')
+		return false;
+
+	return header->root_name < header->strings_size;
+}
+//==============================================================================
+
+
+//==============================================================================
+// Loading.
+//==============================================================================
+bool IndexSnapshot::load()
+// Map the snapshot file into memory. Returns false if there is no snapshot, or
+// it can't be used.
+{
+	unload();
+
+	int fd = open(path.c_str(),O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd,&st) != 0 || st.st_size <= 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	map_size = st.st_size;
+	mapping = mmap(NULL,map_size,PROT_READ,MAP_PRIVATE,fd,0);
+	close(fd);
+
+	if (mapping == MAP_FAILED)
+	{
+		mapping = NULL;
+		map_size = 0;
+		return false;
+	}
+
+	header	= (const SnapshotHeader*)mapping;
+	dirs	= (const SnapshotDir*)((const char*)mapping + header->dirs_offset);
+	files	= (const SnapshotFile*)((const char*)mapping + header->files_offset);
+	strings	= (const char*)mapping + header->strings_offset;
+
+	if (!validate())
+	{
+		cout << "WARNING: Ignoring unreadable index snapshot " << path << endl;
+		unload();
+		return false;
+	}
+
+	return true;
+}
+
+void IndexSnapshot::unload()
+// Unmap the snapshot. Any directories that haven't been expanded yet must be
+// gone before this is called.
+{
+	if (mapping != NULL)
+		munmap(mapping,map_size);
+
+	mapping = NULL;
+	map_size = 0;
+	header = NULL;
+	dirs = NULL;
+	files = NULL;
+	strings = NULL;
+}
+
+bool IndexSnapshot::isLoaded()
+{
+	return mapping != NULL;
+}
+
+string IndexSnapshot::getRootPath()
+{
+	return getString(header->root_name);
+}
+
+int IndexSnapshot::getNumFiles()
+{
+	return header->num_files;
+}
+
+int IndexSnapshot::getNumDirs()
+{
+	return header->num_dirs;
+}
+//==============================================================================
+
+
+//==============================================================================
+// Turning records back into nodes.
+//==============================================================================
+void IndexSnapshot::attach(DirTree* t)
+// Hang the snapshot off the root of the given tree. The root's contents will
+// be read out the first time they are needed.
+{
+	DirNode* root = t->getRootNode();
+
+	root->setTimes(dirs[0].mtime,dirs[0].ctime);
+	root->setSnapshot(this,0);
+
+	t->setNumFiles(header->num_files);
+}
+
+void IndexSnapshot::expand(DirNode* d, int index)
+// Fill a directory with the sub-directories and files recorded for it. The
+// sub-directories are left unexpanded.
+{
+	const SnapshotDir* sd = &dirs[index];
+
+	if ((uint64_t)sd->first_dir + sd->num_dirs > header->num_dirs || (uint64_t)sd->first_file + sd->num_files > header->num_files)
+	{
+		cout << "WARNING: Index snapshot " << path << " is damaged, skipping a directory." << endl;
+		return;
+	}
+
+	for (uint32_t i = 0; i < sd->num_dirs; i++)
+	{
+		int c = sd->first_dir + i;
+
+		DirNode* temp = new DirNode(d,getString(dirs[c].name));
+		temp->setTimes(dirs[c].mtime,dirs[c].ctime);
+		temp->setSnapshot(this,c);
+
+		d->addDirectory(temp);
+	}
+
+	struct stat attr;
+	memset(&attr,0,sizeof(attr));
+
+	for (uint32_t i = 0; i < sd->num_files; i++)
+	{
+		const SnapshotFile* sf = &files[sd->first_file + i];
+
+		attr.st_ino		= sf->ino;
+		attr.st_mode	= sf->mode;
+		attr.st_size	= sf->size;
+		attr.st_blocks	= sf->blocks;
+		attr.st_mtime	= sf->mtime;
+		attr.st_ctime	= sf->ctime;
+
+		d->addFile(new FileNode(d,getString(sf->name),&attr,getString(sf->mime),getString(sf->tags),sf->known));
+	}
+}
+
+const SnapshotDir* IndexSnapshot::getDirRecord(int index)
+// Get a directory's record without making a node for it, or NULL if there is
+// no such record, or its children run off the end of the snapshot.
+{
+	if (index < 0 || (uint32_t)index >= header->num_dirs)
+		return NULL;
+
+	const SnapshotDir* sd = &dirs[index];
+
+	if ((uint64_t)sd->first_dir + sd->num_dirs > header->num_dirs || (uint64_t)sd->first_file + sd->num_files > header->num_files)
+		return NULL;
+
+	return sd;
+}
+
+string IndexSnapshot::getDirName(int index)
+{
+	return getString(dirs[index].name);
+}
+//==============================================================================
+
+
+//==============================================================================
+// Saving.
+//==============================================================================
+static uint32_t addString(string& block, string s)
+// Append a string to the string block, and return its offset.
+{
+	uint32_t offset = block.size();
+
+	block += s;
+	block += '\0';
+
+	return offset;
+}
+
+static uint32_t addSharedString(string& block, map<string,uint32_t>& seen, string s)
+// Like addString(), but strings that repeat a lot (mime-types, tags) are only
+// stored once.
+{
+	map<string,uint32_t>::iterator i = seen.find(s);
+
+	if (i != seen.end())
+		return i->second;
+
+	uint32_t offset = addString(block,s);
+	seen[s] = offset;
+
+	return offset;
+}
+
+static SaveItem saveItem(DirNode* n, IndexSnapshot* s, int i)
+{
+	SaveItem e;
+	e.node = n;
+	e.snapshot = s;
+	e.index = i;
+
+	return e;
+}
+
+void IndexSnapshot::saveRecords(int index, SnapshotDir* sd, vector<SaveItem>* order, vector<SnapshotFile>* file_recs, string& block, map<string,uint32_t>& seen)
+// Copy a directory that was never read out of this snapshot into one being
+// saved. Its files are copied as they are, with their strings added to the new
+// string block, and its sub-directories are queued to be copied in turn. The
+// record's position in the new snapshot is already filled in.
+{
+	const SnapshotDir* old = getDirRecord(index);
+
+	if (old == NULL)
+	{
+		cout << "WARNING: Index snapshot " << path << " is damaged, skipping a directory." << endl;
+		sd->mtime = 0;
+		sd->ctime = 0;
+		return;
+	}
+
+	sd->num_dirs	= old->num_dirs;
+	sd->num_files	= old->num_files;
+	sd->mtime		= old->mtime;
+	sd->ctime		= old->ctime;
+
+	for (uint32_t i = 0; i < old->num_dirs; i++)
+		order->push_back(saveItem(NULL,this,old->first_dir + i));
+
+	for (uint32_t i = 0; i < old->num_files; i++)
+	{
+		SnapshotFile sf = files[old->first_file + i];
+
+		sf.name	= addString(block,getString(sf.name));
+		sf.mime	= (sf.known & FILE_HAVE_TYPE) ? addSharedString(block,seen,getString(sf.mime)) : 0;
+		sf.tags	= addSharedString(block,seen,getString(sf.tags));
+		file_recs->push_back(sf);
+	}
+}
+
+bool IndexSnapshot::save(DirTree* t, string p)
+// Write the given tree out to a snapshot file. The file is written under a
+// temporary name then renamed, so a crash never leaves half a snapshot.
+// Directories that were never read out of the snapshot the tree came from are
+// copied from their records, so saving doesn't read the whole tree out.
+{
+	vector<SnapshotDir> dir_recs;
+	vector<SnapshotFile> file_recs;
+	string block;
+	map<string,uint32_t> seen;
+
+	// Offset zero is the empty string.
+	addString(block,"");
+
+	// Walk the tree breadth-first, so each directory's children are stored
+	// next to each other.
+	vector<SaveItem> order;
+	order.push_back(saveItem(t->getRootNode(),NULL,0));
+
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		SaveItem e = order[i];
+
+		if (e.node != NULL && e.node->getSnapshot() != NULL)
+			e = saveItem(e.node,e.node->getSnapshot(),e.node->getSnapshotIndex());
+
+		SnapshotDir sd;
+		sd.name			= (i == 0) ? 0 : addString(block,(e.node != NULL) ? e.node->getName() : e.snapshot->getDirName(e.index));
+		sd.parent		= -1;
+		sd.first_dir	= order.size();
+		sd.num_dirs		= 0;
+		sd.first_file	= file_recs.size();
+		sd.num_files	= 0;
+
+		if (e.snapshot != NULL)
+		{
+			e.snapshot->saveRecords(e.index,&sd,&order,&file_recs,block,seen);
+			dir_recs.push_back(sd);
+			continue;
+		}
+
+		DirNode* d = e.node;
+		list<DirNode*>* sub = d->getDirectories();
+		list<FileNode*>* fl = d->getFiles();
+
+		sd.num_dirs		= sub->size();
+		sd.num_files	= fl->size();
+		sd.mtime		= d->getModifiedTime();
+		sd.ctime		= d->getChangedTime();
+		dir_recs.push_back(sd);
+
+		for (list<DirNode*>::iterator j = sub->begin(); j != sub->end(); j++)
+			order.push_back(saveItem(*j,NULL,0));
+
+		for (list<FileNode*>::iterator j = fl->begin(); j != fl->end(); j++)
+		{
+			// Only save what has been read already. Asking for the rest would
+			// read it from every file in the tree.
+			int known = (*j)->getKnown();
+
+			struct stat a;
+			memset(&a,0,sizeof(a));
+			if (known & FILE_HAVE_ATTR)
+				a = (*j)->getAttributes();
+
+			string tags = "";
+			if (known & FILE_HAVE_TAGS)
+			{
+				list<string>* tl = (*j)->getTags();
+				for (list<string>::iterator k = tl->begin(); k != tl->end(); k++)
+					tags += (k == tl->begin() ? "" : " ") + *k;
+			}
+
+			SnapshotFile sf;
+			sf.name		= addString(block,(*j)->getName());
+			sf.mime		= (known & FILE_HAVE_TYPE) ? addSharedString(block,seen,(*j)->getMimetype()) : 0;
+			sf.tags		= addSharedString(block,seen,tags);
+			sf.known	= known;
+			sf.unused	= 0;
+			sf.mode		= a.st_mode;
+			sf.ino		= a.st_ino;
+			sf.size		= a.st_size;
+			sf.blocks	= a.st_blocks;
+			sf.mtime	= a.st_mtime;
+			sf.ctime	= a.st_ctime;
+			file_recs.push_back(sf);
+		}
+	}
+
+	// Fill in the parent links, now that every directory has an index.
+	for (size_t i = 0; i < dir_recs.size(); i++)
+		for (uint32_t j = 0; j < dir_recs[i].num_dirs; j++)
+			dir_recs[dir_recs[i].first_dir + j].parent = i;
+
+	SnapshotHeader h;
+	memset(&h,0,sizeof(h));
+	memcpy(h.magic,SNAPSHOT_MAGIC,sizeof(h.magic));
+	h.version			= SNAPSHOT_VERSION;
+	h.num_dirs			= dir_recs.size();
+	h.num_files			= file_recs.size();
+	h.root_name			= addString(block,t->getRootPath());
+	h.dirs_offset		= sizeof(h);
+	h.files_offset		= h.dirs_offset + dir_recs.size()*sizeof(SnapshotDir);
+	h.strings_offset	= h.files_offset + file_recs.size()*sizeof(SnapshotFile);
+	h.strings_size		= block.size();
+
+	string temp_path = p + ".tmp";
+	FILE* out = fopen(temp_path.c_str(),"wb");
+	if (out == NULL)
+	{
+		cout << "WARNING: Could not write index snapshot " << temp_path << endl;
+		return false;
+	}
+
+	bool ok = fwrite(&h,sizeof(h),1,out) == 1;
+	if (!dir_recs.empty())
+		ok = ok && fwrite(&dir_recs[0],sizeof(SnapshotDir),dir_recs.size(),out) == dir_recs.size();
+	if (!file_recs.empty())
+		ok = ok && fwrite(&file_recs[0],sizeof(SnapshotFile),file_recs.size(),out) == file_recs.size();
+	ok = ok && fwrite(block.data(),1,block.size(),out) == block.size();
+	ok = (fclose(out) == 0) && ok;
+
+	if (!ok || rename(temp_path.c_str(),p.c_str()) != 0)
+	{
+		cout << "WARNING: Could not write index snapshot " << p << endl;
+		unlink(temp_path.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+string IndexSnapshot::cacheDirectory()
+// Work out where cached files go, $XDG_CACHE_HOME/starnavi (or
+// ~/.cache/starnavi), creating the directory if needed.
+{
+	string dir;
+	const char* cache = getenv("XDG_CACHE_HOME");
+	const char* home = getenv("HOME");
+
+	if (cache != NULL && cache[0] != '\0')
+		dir = cache;
+	else if (home != NULL)
+	{
+		dir = (string)home + "/.cache";
+		mkdir(dir.c_str(),0700);
+	}
+	else
+		dir = "/tmp";
+
+	dir += "/starnavi";
+	mkdir(dir.c_str(),0700);
+
+	return dir;
+}
+
+string IndexSnapshot::pathFor(string root)
+// Work out where the snapshot for the given root directory lives. Snapshots
+// are named by a hash of the root path, in the cache directory.
+{
+	string dir = cacheDirectory();
+
+	char name[32];
+	snprintf(name,sizeof(name),"%016llx.idx",hashString64(root));
+
+	return dir + "/" + name;
+}
+//==============================================================================
@@ -1,41 +1,369 @@
 //==============================================================================
 // Date Created:		4 February 2011
-// Last Updated:		16 May 2011
+// Last Updated:		18 October 2026
 //
 // File name:			Indexer.cpp
 // Programmer:			Matthew Hydock
 //
 // File description:	A class to index a file system recursively from a given
-//						directory. Most of the work is done in DirTree.cpp.
+//						directory. The directories are read in parallel by a
+//						DirWalker, then merged into a DirTree. A tree loaded
+//						from a snapshot can be refreshed, which only reads the
+//						directories that have changed since. A build can also
+//						run in the background, with what has been found so far
+//						collected every so often so it can be shown.
 //==============================================================================
 
 #include "Indexer.h"
 
+#include <fcntl.h>
+#include <map>
+#include <sys/time.h>
+
 //==============================================================================
 // Private methods
 //==============================================================================
-void Indexer::build(string dir)
-// Recursive method to build a directory hierarchy.
+void Indexer::mergeResults(DirWalker* w, TreeChanges* changes)
+// Attach every directory the walker has finished to the tree. Each listing is
+// already sorted, so the tree comes out the same no matter which order the
+// workers finished in. If given a change set, everything attached is noted in
+// it as added.
 {
-	DIR* d = opendir(dir.c_str());
-	dirent* dr = readdir(d);
+	list<DirListing*>* results = w->takeResults();
 	
-	while (dr != NULL)
+	for (list<DirListing*>::iterator i = results->begin(); i != results->end(); i++)
 	{
-		if (dr->d_type == DT_REG)
+		dir_tree->attach((*i)->dir,&(*i)->files,&(*i)->dirs);
+		
+		if (changes != NULL)
 		{
-			if (dr->d_name[0] != '.' && strstr(dr->d_name, ".tags") == NULL)
-			// If a file, but not a tag file, add to file list
-				dir_tree->add(dir, dr->d_name);
+			for (size_t j = 0; j < (*i)->files.size(); j++)
+				changes->addFile((*i)->files[j]);
+			for (size_t j = 0; j < (*i)->dirs.size(); j++)
+				changes->addDirectory((*i)->dirs[j]);
 		}
-		else if (dr->d_type == DT_DIR && (strcmp(dr->d_name, "..") != 0 && strcmp(dr->d_name, ".") != 0))
-		// If a directory, but not ./ or ../, then immediately dive into it.
-			build(dir + dr->d_name + "/");
+		
+		delete *i;
+	}
+	
+	delete results;
+}
+
+void Indexer::refreshDirectory(DirNode* d, int fd, RefreshStats* stats, vector<DirNode*>* fresh, set<DirNode*>* skip, TreeChanges* changes)
+// Check an open directory against the file system, then do the same for
+// everything below it. A directory whose times match the ones recorded for it
+// has had no files added, removed, or renamed, so its files are kept without
+// looking at them. Its sub-directories still have to be checked, as changes
+// further down don't touch it. They are opened relative to this one, so no
+// paths are built unless something goes wrong. An unchanged directory that is
+// still in the snapshot is checked against the snapshot's records instead, so
+// it isn't read out.
+{
+	struct stat st;
+	
+	if (fstat(fd,&st) != 0)
+	{
+		cout << "WARNING: Could not refresh directory " << d->getPath() << endl;
+		return;
+	}
+	
+	bool same = st.st_mtime == d->getModifiedTime() && st.st_ctime == d->getChangedTime();
+	
+	if (same && d->getSnapshot() != NULL)
+	{
+		const SnapshotDir* sd = d->getSnapshot()->getDirRecord(d->getSnapshotIndex());
+		
+		if (sd != NULL)
+		{
+			vector<string> trail;
 			
-		dr = readdir(d);
+			stats->reused += sd->num_files;
+			refreshRecords(d,&trail,d->getSnapshot(),d->getSnapshotIndex(),fd,stats,fresh,skip,changes);
+			return;
+		}
 	}
 	
-	closedir(d);
+	if (same)
+		stats->reused += d->getFiles()->size();
+	else
+		rereadDirectory(d,fd,stats,fresh,skip,changes);
+	
+	// New directories are left for the walker. If a directory has gone, this
+	// one has changed too, and has removed it already.
+	list<DirNode*>* sub = d->getDirectories();
+	for (list<DirNode*>::iterator i = sub->begin(); i != sub->end(); i++)
+	{
+		if (skip->find(*i) != skip->end())
+			continue;
+		
+		int sub_fd = DirWalker::openDirectory(fd,(*i)->getName());
+		if (sub_fd < 0)
+		{
+			cout << "WARNING: Could not refresh directory " << (*i)->getPath() << endl;
+			continue;
+		}
+		
+		refreshDirectory(*i,sub_fd,stats,fresh,skip,changes);
+		close(sub_fd);
+	}
+}
+
+void Indexer::refreshRecords(DirNode* anchor, vector<string>* trail, IndexSnapshot* s, int index, int fd, RefreshStats* stats, vector<DirNode*>* fresh, set<DirNode*>* skip, TreeChanges* changes)
+// Check the sub-directories of an unchanged directory that hasn't been read out
+// of the snapshot yet, going by their records, so no nodes are made for them.
+// The directory is the one reached from anchor by the names in trail. Only
+// when a sub-directory has changed are the directories on the way to it read
+// out, so it can be read again.
+{
+	const SnapshotDir* sd = s->getDirRecord(index);
+	
+	for (uint32_t i = 0; i < sd->num_dirs; i++)
+	{
+		int c = sd->first_dir + i;
+		const SnapshotDir* sc = s->getDirRecord(c);
+		string name = s->getDirName(c);
+		
+		int sub_fd = DirWalker::openDirectory(fd,name);
+		if (sub_fd < 0)
+		{
+			cout << "WARNING: Could not refresh directory " << name << endl;
+			continue;
+		}
+		
+		trail->push_back(name);
+		
+		struct stat st;
+		bool same = sc != NULL && fstat(sub_fd,&st) == 0 && st.st_mtime == sc->mtime && st.st_ctime == sc->ctime;
+		
+		if (same)
+		{
+			stats->reused += sc->num_files;
+			refreshRecords(anchor,trail,s,c,sub_fd,stats,fresh,skip,changes);
+		}
+		else
+		{
+			DirNode* d = anchor;
+			for (size_t k = 0; k < trail->size() && d != NULL; k++)
+				d = d->getDirectory((*trail)[k]);
+			
+			if (d != NULL)
+				refreshDirectory(d,sub_fd,stats,fresh,skip,changes);
+		}
+		
+		trail->pop_back();
+		close(sub_fd);
+	}
+}
+
+void Indexer::rereadDirectory(DirNode* d, int fd, RefreshStats* stats, vector<DirNode*>* fresh, set<DirNode*>* skip, TreeChanges* changes)
+// Read an open directory that has changed, and bring its contents up to date.
+// Files and directories that are gone are removed. Files that are still here
+// are only looked at again if their inode, size, or modification time differ;
+// files whose attributes were never read have nothing to go out of date, and
+// just take the attributes read with the listing. New sub-directories are
+// added empty, and listed in fresh so they can be walked afterwards. If given
+// a change set, every change is noted in it, and removed nodes are handed
+// over to it instead of being deleted.
+{
+	vector<string> file_names;
+	vector<string> dir_names;
+	map<string,struct stat> attrs;
+	struct stat st;
+	
+	stats->dirs_read++;
+	
+	if (!DirWalker::listDirectory(fd,&file_names,&dir_names,&st,&attrs))
+	{
+		cout << "WARNING: Could not read directory " << d->getPath() << endl;
+		return;
+	}
+	
+	map<string,FileNode*> old_files;
+	list<FileNode*>* fl = d->getFiles();
+	for (list<FileNode*>::iterator i = fl->begin(); i != fl->end(); i++)
+		old_files[(*i)->getName()] = *i;
+	
+	map<string,DirNode*> old_dirs;
+	list<DirNode*>* dl = d->getDirectories();
+	for (list<DirNode*>::iterator i = dl->begin(); i != dl->end(); i++)
+		old_dirs[(*i)->getName()] = *i;
+	
+	// Files that are new, or still here.
+	for (size_t i = 0; i < file_names.size(); i++)
+	{
+		map<string,FileNode*>::iterator f = old_files.find(file_names[i]);
+		
+		if (f == old_files.end())
+		{
+			map<string,struct stat>::iterator a = attrs.find(file_names[i]);
+			FileNode* temp;
+			
+			if (a == attrs.end())
+				temp = new FileNode(d,file_names[i]);
+			else
+				temp = new FileNode(d,file_names[i],&a->second,"","",FILE_HAVE_ATTR);
+			
+			d->addFile(temp);
+			stats->added++;
+			
+			if (changes != NULL)
+				changes->addFile(temp);
+			continue;
+		}
+		
+		FileNode* old = f->second;
+		map<string,struct stat>::iterator a = attrs.find(file_names[i]);
+		bool differs = false;
+		
+		if (a != attrs.end() && (old->getKnown() & FILE_HAVE_ATTR))
+		{
+			struct stat* now = &a->second;
+			differs = now->st_ino != old->getInode() || now->st_size != old->getSize() || now->st_mtime != old->getModifiedTime();
+		}
+		else if (a != attrs.end())
+			// Attributes that were never read are filled in from the listing.
+			old->refresh(&a->second);
+		
+		if (differs)
+		{
+			old->refresh(&a->second);
+			stats->changed++;
+			
+			if (changes != NULL)
+				changes->changeFile(f->second);
+		}
+		else
+			stats->reused++;
+		
+		old_files.erase(f);
+	}
+	
+	// Whatever is left over has been removed.
+	for (map<string,FileNode*>::iterator i = old_files.begin(); i != old_files.end(); i++)
+	{
+		if (changes != NULL)
+			changes->removeFile(d->removeFile(i->second));
+		else
+			d->deleteFile(i->second);
+		
+		stats->removed++;
+	}
+	
+	// The same for sub-directories.
+	for (size_t i = 0; i < dir_names.size(); i++)
+	{
+		map<string,DirNode*>::iterator sd = old_dirs.find(dir_names[i]);
+		
+		if (sd == old_dirs.end())
+		{
+			DirNode* temp = new DirNode(d,dir_names[i]);
+			d->addDirectory(temp);
+			fresh->push_back(temp);
+			skip->insert(temp);
+			
+			if (changes != NULL)
+				changes->addDirectory(temp);
+		}
+		else
+			old_dirs.erase(sd);
+	}
+	
+	for (map<string,DirNode*>::iterator i = old_dirs.begin(); i != old_dirs.end(); i++)
+	{
+		stats->removed += i->second->getTotals()->files;
+		
+		if (changes != NULL)
+			changes->removeDirectory(d->removeDirectory(i->second));
+		else
+			d->deleteDirectory(i->second);
+	}
+	
+	d->setTimes(st.st_mtime,st.st_ctime);
+}
+
+void Indexer::walkNew(vector<DirNode*>* fresh, RefreshStats* stats, TreeChanges* changes)
+// Walk the new directories found by a refresh, in parallel, and attach what
+// was found. The tree's file count is worked out from what the refresh did,
+// as counting would read the whole snapshot out.
+{
+	int num_files = dir_tree->getNumFiles();
+	
+	if (!fresh->empty())
+	{
+		DirWalker walker(num_threads);
+		walker.start(fresh);
+		walker.wait();
+		
+		mergeResults(&walker,changes);
+		
+		stats->added += walker.getFilesFound();
+		stats->dirs_read += walker.getDirsFound() + fresh->size();
+	}
+	
+	dir_tree->setNumFiles(num_files + stats->added - stats->removed);
+}
+
+void Indexer::reportRefresh(RefreshStats* stats, struct timeval* start)
+// Print what a refresh did, and how long it took.
+{
+	cout << "refreshed index in " << secondsSince(start) << " s: " << stats->dirs_read << " directories read, ";
+	cout << stats->reused << " files reused, " << stats->added << " added, ";
+	cout << stats->removed << " removed, " << stats->changed << " changed" << endl;
+}
+
+double Indexer::secondsSince(struct timeval* start)
+// Get the number of seconds since the given time.
+{
+	struct timeval now;
+	gettimeofday(&now,NULL);
+	
+	return (now.tv_sec-start->tv_sec) + (now.tv_usec-start->tv_usec)/1000000.0;
+}
+
+void Indexer::finishBuild()
+// Wrap up a build once the walker is done: attach anything left over, report
+// how fast it went, and save a snapshot for next time.
+{
+	walker->wait();
+	mergeResults(walker);
+	dir_tree->layOut();
+	
+	double secs = secondsSince(&build_start);
+	
+	cout << "indexed " << walker->getFilesFound() << " files in " << walker->getDirsFound()+1 << " directories, ";
+	cout << secs << " s with " << walker->getNumThreads() << " threads (";
+	cout << (int)(walker->getFilesFound()/(secs > 0 ? secs : 1)) << " files/sec)" << endl;
+	
+	delete walker;
+	walker = NULL;
+	
+	saveSnapshot();
+}
+
+bool Indexer::loadSnapshot()
+// Try to use the snapshot saved by the last run. Directories are read out of
+// the snapshot as they are looked at, so this is quick no matter how big the
+// tree is.
+{
+	snapshot = new IndexSnapshot(IndexSnapshot::pathFor(dir_tree->getRootPath()));
+	
+	if (snapshot->load() && snapshot->getRootPath().compare(dir_tree->getRootPath()) == 0)
+	{
+		snapshot->attach(dir_tree);
+		cout << "loaded index snapshot of " << snapshot->getNumFiles() << " files" << endl;
+		return true;
+	}
+	
+	delete snapshot;
+	snapshot = NULL;
+	
+	return false;
+}
+
+void Indexer::saveSnapshot()
+// Save the tree, so the next run can skip indexing.
+{
+	IndexSnapshot::save(dir_tree,IndexSnapshot::pathFor(dir_tree->getRootPath()));
 }
 //==============================================================================
 
@@ -43,20 +371,47 @@ void Indexer::build(string dir)
 //==============================================================================
 // Constructor/Deconstructor
 //==============================================================================	
-Indexer::Indexer(string root_path)
-// Constructor. Initialized the number of files, and sets the root path.
+Indexer::Indexer(string root_path, int threads, bool rebuild, bool background)
+// Constructor. Sets the root path and the number of worker threads (zero for
+// one per processor). Uses the snapshot from the last run if there is one and
+// a rebuild wasn't asked for, otherwise indexes and saves a new snapshot. If
+// asked to, the indexing is left running in the background, and the tree
+// fills in as collect() is called.
 {
 	dir_tree = new DirTree(root_path);
+	snapshot = NULL;
+	num_threads = threads;
+	walker = NULL;
+	last_publish = 0;
 	
-	build();
+	if (rebuild || !loadSnapshot())
+	{
+		if (background)
+			startBuild();
+		else
+			build();
+	}
+	else
+	{
+		// Catch up with whatever changed since the snapshot was saved.
+		RefreshStats stats = refresh();
+		
+		if (stats.dirs_read > 0)
+			saveSnapshot();
+	}
 }
 
 
 Indexer::~Indexer()
-// Deconstructor. Clear and delete the file list.
+// Deconstructor. Stop any build still going, then delete the tree, then the
+// snapshot it may still be reading from.
 {
-	clearTree();
+	if (walker != NULL)
+		walker->stop();
+	delete walker;
+	
 	delete dir_tree;
+	delete snapshot;
 }
 //==============================================================================
 
@@ -65,15 +420,199 @@ Indexer::~Indexer()
 // Public methods
 //==============================================================================
 void Indexer::build()
+// Walk the tree from the root, using a pool of worker threads, and wait for it
+// to finish.
+{
+	startBuild();
+	wait();
+}
+
+
+void Indexer::startBuild()
+// Start walking the tree from the root with a pool of worker threads, and
+// return straight away. What the workers find is attached to the tree by
+// collect() or wait(), so the tree is only ever changed by the calling thread.
+{
+	if (walker != NULL)
+		return;
+	
+	gettimeofday(&build_start,NULL);
+	last_publish = 0;
+	
+	walker = new DirWalker(num_threads);
+	walker->start(dir_tree->getRootNode());
+}
+
+
+TreeChanges* Indexer::collect()
+// While a build is running in the background, attach whatever the workers have
+// found since last time, and hand it back as a change set so it can be shown.
+// This happens at most every INDEX_PUBLISH_INTERVAL seconds, and once more
+// when the build finishes; otherwise, NULL is returned. The change set may be
+// empty, if the workers are busy on something big. The caller owns it.
+{
+	if (walker == NULL)
+		return NULL;
+	
+	double t = secondsSince(&build_start);
+	bool done = walker->isDone();
+	
+	if (!done && t-last_publish < INDEX_PUBLISH_INTERVAL)
+		return NULL;
+	
+	last_publish = t;
+	
+	TreeChanges* changes = new TreeChanges;
+	mergeResults(walker,changes);
+	
+	if (done)
+		finishBuild();
+	
+	return changes;
+}
+
+
+void Indexer::wait()
+// Block until a build running in the background is finished.
+{
+	if (walker != NULL)
+		finishBuild();
+}
+
+
+bool Indexer::isBuilding()
+{
+	return walker != NULL;
+}
+
+
+int Indexer::getFilesFound()
+// Get the number of files found so far by a build, or the number in the tree
+// if there isn't one.
+{
+	if (walker == NULL)
+		return dir_tree->getNumFiles();
+	
+	return walker->getFilesFound();
+}
+
+
+int Indexer::getDirsPending()
+// Get the number of directories a build still has to read.
+{
+	if (walker == NULL)
+		return 0;
+	
+	return walker->getDirsPending();
+}
+
+
+int Indexer::getFilesPerSecond()
+// Get how fast a build is going.
+{
+	if (walker == NULL)
+		return 0;
+	
+	double secs = secondsSince(&build_start);
+	
+	return (int)(walker->getFilesFound()/(secs > 0 ? secs : 1));
+}
+
+
+RefreshStats Indexer::refresh(TreeChanges* changes)
+// Bring the tree up to date with the file system, reading only the directories
+// that have changed since they were last read. Directories that are new are
+// walked in parallel, the same as in build(). Reports what was done, and how
+// long it took. If given a change set, every change is noted in it.
 {
-	build(dir_tree->getRootPath());
+	struct timeval start;
+	gettimeofday(&start,NULL);
+	
+	RefreshStats stats;
+	memset(&stats,0,sizeof(stats));
+	
+	vector<DirNode*> fresh;
+	set<DirNode*> skip;
+	
+	int fd = DirWalker::openDirectory(dir_tree->getRootNode());
+	if (fd >= 0)
+	{
+		refreshDirectory(dir_tree->getRootNode(),fd,&stats,&fresh,&skip,changes);
+		close(fd);
+	}
+	
+	walkNew(&fresh,&stats,changes);
+	dir_tree->layOut();
+	
+	reportRefresh(&stats,&start);
+	
+	return stats;
+}
+
+
+RefreshStats Indexer::refreshDirectories(list<DirNode*>* dirs, TreeChanges* changes)
+// Re-read just the given directories, whether their times have changed or not,
+// such as when something is watching the tree and knows which directories
+// have had things happen in them. Parents are read before their children, so
+// a directory that was removed along with its parent is skipped.
+{
+	struct timeval start;
+	gettimeofday(&start,NULL);
+	
+	RefreshStats stats;
+	memset(&stats,0,sizeof(stats));
+	
+	vector<DirNode*> fresh;
+	set<DirNode*> skip;
+	
+	// Sort the directories by depth.
+	vector<pair<int,DirNode*> > order;
+	for (list<DirNode*>::iterator i = dirs->begin(); i != dirs->end(); i++)
+	{
+		int depth = 0;
+		for (DirNode* p = (*i)->getParent(); p != NULL; p = p->getParent())
+			depth++;
+		
+		order.push_back(pair<int,DirNode*>(depth,*i));
+	}
+	
+	sort(order.begin(),order.end());
+	
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		DirNode* d = order[i].second;
+		
+		if (skip.find(d) != skip.end() || (changes != NULL && changes->isRemoved(d)))
+			continue;
+		
+		int fd = DirWalker::openDirectory(d);
+		if (fd < 0)
+			continue;
+		
+		rereadDirectory(d,fd,&stats,&fresh,&skip,changes);
+		close(fd);
+	}
+	
+	walkNew(&fresh,&stats,changes);
+	
+	reportRefresh(&stats,&start);
+	
+	return stats;
 }
 
 
 void Indexer::changeRoot(string new_root)
 {
+	if (walker != NULL)
+		walker->stop();
+	delete walker;
+	walker = NULL;
+	
 	delete dir_tree;
 	dir_tree = new DirTree(new_root);
+	
+	delete snapshot;
+	snapshot = NULL;
 }
 
 
@@ -84,14 +623,23 @@ void Indexer::clearTree()
 }
 
 
-DirTree* Indexer::getDirectoryTree()
-// Get the file list that the indexer filled.
+void Indexer::setNumThreads(int t)
+// Set the number of worker threads used by the next build. Zero means one per
+// processor.
 {
-	return dir_tree;
+	num_threads = t;
 }
 
-list<FileNode*>* Indexer::getFileList()
+
+int Indexer::getNumThreads()
 {
-	return dir_tree->getFileList();
+	return num_threads;
+}
+
+
+DirTree* Indexer::getDirectoryTree()
+// Get the file list that the indexer filled.
+{
+	return dir_tree;
 }
 //==============================================================================
@@ -0,0 +1,114 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			LabelCache.cpp
+// Programmer:			Matthew Hydock
+//
+// File description:	Keeps the name labels of stars and sectors, so sweeping
+//						the mouse across a galaxy doesn't leave a label behind
+//						for everything it passed over. A label handed out stays
+//						good until a label that isn't cached is asked for.
+//==============================================================================
+
+#include "LabelCache.h"
+
+#include <sstream>
+
+list<LabelCache::Entry> LabelCache::entries;
+map<string,list<LabelCache::Entry>::iterator> LabelCache::index;
+
+size_t LabelCache::bytes = 0;
+int LabelCache::hits = 0;
+int LabelCache::misses = 0;
+
+//==============================================================================
+// Private methods.
+//==============================================================================
+DrawText* LabelCache::makeLabel(string text, string font, int size)
+// Make a label, the way every star and sector label looks.
+{
+	DrawText* label = new DrawText(text,font,size);
+	label->setBackgroundColor(.2,.2,.2,.25);
+	label->setHorzPadding(5);
+	label->setVertPadding(4);
+
+	return label;
+}
+
+void LabelCache::evict()
+// Let go of the least recently used labels until the cache is within its
+// budget. The newest label is always kept, however big it is, as it is about
+// to be drawn.
+{
+	while (bytes > LABEL_CACHE_BYTES && entries.size() > 1)
+	{
+		Entry& e = entries.back();
+
+		bytes -= e.bytes;
+		delete e.label;
+		index.erase(e.key);
+		entries.pop_back();
+	}
+}
+//==============================================================================
+
+
+//==============================================================================
+// Public methods.
+//==============================================================================
+DrawText* LabelCache::get(string text, string font, int size)
+// Get the label for the given text, in the given font and size, making it if
+// it isn't cached. The label belongs to the cache, and may be deleted the
+// next time a label that isn't cached is asked for, so it should be fetched
+// again each time it is drawn rather than kept.
+{
+	ostringstream oss;
+	oss << font << '\n' << size << '\n' << text;
+	string key = oss.str();
+
+	map<string,list<Entry>::iterator>::iterator i = index.find(key);
+
+	if (i != index.end())
+	{
+		hits++;
+		entries.splice(entries.begin(),entries,i->second);
+		return entries.front().label;
+	}
+
+	misses++;
+
+	Entry e;
+	e.key = key;
+	e.label = makeLabel(text,font,size);
+	e.bytes = e.label->getByteSize() + key.size();
+
+	entries.push_front(e);
+	index[key] = entries.begin();
+	bytes += e.bytes;
+
+	evict();
+
+	return e.label;
+}
+
+size_t LabelCache::getBytes()
+{
+	return bytes;
+}
+
+int LabelCache::getNumLabels()
+{
+	return entries.size();
+}
+
+int LabelCache::getHits()
+{
+	return hits;
+}
+
+int LabelCache::getMisses()
+{
+	return misses;
+}
+//==============================================================================
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		13 May 2011
-// Last Updated:		29 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			LabeledDrawable.h
 // Programmer:			Matthew Hydock
@@ -12,28 +12,20 @@
 #include "LabeledDrawable.h"
 
 DrawText* LabeledDrawable::getLabel()
-// Get the text object of the star.
+// Get the label with the item's name from the label cache. It may be deleted
+// once other labels have been made, so get it again each time it is used.
 {
-	return label;
+	return LabelCache::get(name);
 }
 
 void LabeledDrawable::initLabel()
+// Make sure the label is in the cache, without drawing it.
 {
-	//cout << "initializing label\n";
-	
-	if (label == NULL)
-	{
-		label = new DrawText(name);
-		label->setBackgroundColor(.2,.2,.2,.25);
-		label->setHorzPadding(5);
-		label->setVertPadding(4);
-	}
-	
-	//cout << "label initialized\n";
+	LabelCache::get(name);
 }	
 
 void LabeledDrawable::drawLabel()
 // Draw the name of the star.
 {
-	label->draw();
+	getLabel()->draw();
 }
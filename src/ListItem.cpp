@@ -83,8 +83,6 @@ void ListItem::toggleSelected()
 		text->setTextColor(getSelectedTextColor());
 	else if (!selected)
 		text->setTextColor(getDefaultTextColor());
-	
-	text->refreshTexture();
 }
 
 bool ListItem::isSelected()
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		14 February 2011
-// Last Updated:		14 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			MainClass.cpp
 // Programmer:			Matthew Hydock
@@ -20,9 +20,19 @@
 #include "StatusBar.h"
 #include "Button.h"
 
+#include <sys/time.h>
+
 #define START_W 800
 #define START_H 600
 
+// The most frames drawn a second, and how often the file system is checked
+// when nothing is moving, in milliseconds.
+#define DEFAULT_FPS 30
+#define IDLE_POLL 100
+
+// How long after a click further clicks are ignored, in seconds.
+#define CLICK_DELAY 0.25
+
 //==============================================================================
 // Method definitions.
 //==============================================================================
@@ -30,7 +40,10 @@ void init();
 void buildGUI();
 
 void display();
-void idleFunc();
+void tick(int id);
+void schedule(int wait);
+void damage();
+int untilNextFrame();
 void reshape(int w, int h);
 
 void mouseClick(int button, int state, int x, int y);
@@ -45,10 +58,38 @@ void mouseHover(int x, int y);
 bool Star::starSelectionMode = false;
 
 list<Container*> containers;
+StateManager* sm = NULL;
 int oldW = START_W, oldH = START_H;
 int oldX = 0, oldY = 0;
-int delay = 0;
 string path;
+int threads = 0;
+bool rebuild = false;
+
+// Frame pacing. The screen is only redrawn when it has been damaged, by input,
+// by the galaxies changing, or by the galaxy turning, and no more than max_fps
+// times a second. Only the latest scheduled tick is acted on.
+int max_fps = DEFAULT_FPS;
+bool animating = true;
+bool damaged = true;
+double last_frame = 0;
+double last_tick = 0;
+double next_tick = 0;
+double last_click = 0;
+int tick_id = 0;
+//==============================================================================
+
+
+//==============================================================================
+// Helpers.
+//==============================================================================
+static double now()
+// The current time, in seconds.
+{
+	struct timeval t;
+	gettimeofday(&t,NULL);
+	
+	return t.tv_sec + t.tv_usec/1000000.0;
+}
 //==============================================================================
 
 
@@ -78,7 +119,7 @@ void init()
 void buildGUI()
 {
 	// Create the galaxy state manager and bind it to a container
-	StateManager *sm = new StateManager(path);
+	sm = new StateManager(path,threads,rebuild);
 	Functor<StateManager> *f_sm = new Functor<StateManager>(sm, &StateManager::navigate);
 
 	// Create new container to hold state manager.
@@ -115,22 +156,22 @@ void buildGUI()
 	bl->addDrawable(dir);
 
 	// Create the 'by name' button, and add to the drawables list.
-	AbstractFunctor *f_name = new NullFunctor();
+	AbstractFunctor *f_name = new Functor<StateManager>(sm, &StateManager::setNameMode);
 	Button *name = new Button("By Name",f_name,0,0,145,30);
 	bl->addDrawable(name);
 
 	// Create the 'by date' button, and add to the drawables list.
-	AbstractFunctor *f_date = new NullFunctor();
+	AbstractFunctor *f_date = new Functor<StateManager>(sm, &StateManager::setDateMode);
 	Button *date = new Button("By Date",f_date,0,0,145,30);
 	bl->addDrawable(date);
 
 	// Create the 'by size' button, and add to the drawables list.
-	AbstractFunctor *f_size = new NullFunctor();
+	AbstractFunctor *f_size = new Functor<StateManager>(sm, &StateManager::setSizeMode);
 	Button *size = new Button("By Size",f_size,0,0,145,30);
 	bl->addDrawable(size);
 
 	// Create the 'by type' button, and add to the drawables list.
-	AbstractFunctor *f_type = new NullFunctor();
+	AbstractFunctor *f_type = new Functor<StateManager>(sm, &StateManager::setTypeMode);
 	Button *type = new Button("By Type",f_type,0,0,145,30);
 	bl->addDrawable(type);
 	
@@ -200,12 +241,73 @@ void display()
 	glFlush();
 	glutSwapBuffers();
 	
-	delay++;
+	damaged = false;
+	last_frame = now();
+}
+
+void tick(int id)
+// Do the background work, move the galaxy on, and draw a frame if the screen
+// is damaged and one is due. While there is work to do, the next tick comes
+// straight away; otherwise it waits for the next frame if anything is moving,
+// or checks the file system every so often if not.
+{
+	if (id != tick_id)
+		return;
+	
+	double t = now();
+	
+	// Pick up any changes to the file system.
+	bool busy = sm->update();
+	if (busy)
+		damaged = true;
+	
+	if (animating && sm->animate(t-last_tick))
+		damaged = true;
+	
+	last_tick = t;
+	
+	int wait = IDLE_POLL;
+	
+	if (damaged && untilNextFrame() == 0)
+	{
+		glutPostRedisplay();
+		
+		if (animating)
+			wait = 1000/max_fps+1;
+	}
+	else if (damaged)
+		wait = untilNextFrame();
+	else if (animating)
+		wait = 1000/max_fps;
+	
+	schedule(busy ? 0 : wait);
+}
+
+void schedule(int wait)
+// Set the next tick for wait milliseconds from now, replacing any other.
+{
+	tick_id++;
+	next_tick = now() + wait/1000.0;
+	glutTimerFunc(wait,tick,tick_id);
+}
+
+void damage()
+// Note that the screen needs redrawing, and see that it is once a frame is
+// due, bringing the next tick forward if need be.
+{
+	damaged = true;
+	
+	int wait = untilNextFrame();
+	if (now() + wait/1000.0 < next_tick)
+		schedule(wait);
 }
 
-void idleFunc()
+int untilNextFrame()
+// How many milliseconds until another frame can be drawn.
 {
-	glutPostRedisplay();
+	double wait = last_frame + 1.0/max_fps - now();
+	
+	return (wait > 0) ? (int)(wait*1000)+1 : 0;
 }
 
 void reshape(int w, int h)
@@ -233,7 +335,7 @@ void reshape(int w, int h)
 	
 	cout << oldW << "  " << oldH << endl;
 	
-	glutPostRedisplay();
+	damage();
 }
 //==============================================================================
 
@@ -243,10 +345,10 @@ void reshape(int w, int h)
 //==============================================================================
 void mouseClick(int button, int state, int x, int y)
 {
-	if (delay < 50)
+	if (now()-last_click < CLICK_DELAY)
 		return;
 	
-	delay = 0;
+	last_click = now();
 	
 	if (button == GLUT_RIGHT_BUTTON)
 	{
@@ -263,6 +365,8 @@ void mouseClick(int button, int state, int x, int y)
 			if ((*i)->isColliding(x,newY))
 				(*i)->activate();
 	}
+	
+	damage();
 }	
 
 void mouseHover(int x, int y)
@@ -272,6 +376,8 @@ void mouseHover(int x, int y)
 	
 	for (list<Container*>::iterator i = containers.begin(); i != containers.end(); i++)
 		(*i)->isColliding(x,newY);
+	
+	damage();
 }
 //==============================================================================
 
@@ -294,23 +400,65 @@ int main(int argc, char *argv[])
 	// Initialize the environment.
 	init();
 
+	// Read the options. -j sets the number of indexing threads, -r ignores the
+	// saved index and rebuilds it. -s and -a set the most sectors a galaxy can
+	// have, and the smallest arc a directory can have a sector with, before
+	// directories are folded together. -n sets how many sectors to aim for when
+	// splitting files up by name, date, size or type. -p sets how many stars a
+	// galaxy can have before they are drawn as point sprites. -f sets the most
+	// frames drawn a second; -f 0 stops the galaxy turning, so frames are only
+	// drawn when something changes.
+	int opt;
+	int max_sectors = GALAXY_MAX_SECTORS;
+	float min_arc = GALAXY_MIN_SECTOR_ARC;
+	while ((opt = getopt(argc,argv,"j:rs:a:n:p:f:")) != -1)
+	{
+		if (opt == 'j')
+			threads = atoi(optarg);
+		else if (opt == 'r')
+			rebuild = true;
+		else if (opt == 's')
+			max_sectors = atoi(optarg);
+		else if (opt == 'a')
+			min_arc = atof(optarg);
+		else if (opt == 'n')
+			Galaxy::setClusterSectors(atoi(optarg));
+		else if (opt == 'p')
+			Galaxy::setSpriteStars(atoi(optarg));
+		else if (opt == 'f')
+		{
+			if (atoi(optarg) > 0)
+				max_fps = atoi(optarg);
+			else
+				animating = false;
+		}
+		else
+			return 1;
+	}
+	
+	Galaxy::setSectorLimits(max_sectors,min_arc);
+	
 	// Set the path
-	if (argc > 2)
+	if (argc-optind > 1)
 		return 1;
 		
-	if (argc == 1)
+	if (optind == argc)
 		path = "./";
 	else
-		path = (string)argv[1];
+		path = (string)argv[optind];
 	
 	// Build the GUI components.
 	buildGUI();
 
 	// Register display methods
 	glutDisplayFunc(display);
-	glutIdleFunc(idleFunc);
 	glutReshapeFunc(reshape);
 	
+	// Start ticking. There is no idle function, so nothing runs between
+	// ticks and input.
+	last_tick = now();
+	schedule(0);
+	
 	// Register input methods.
 	glutMouseFunc(mouseClick);
 	glutPassiveMotionFunc(mouseHover);
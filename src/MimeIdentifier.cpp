@@ -1,12 +1,13 @@
 //==============================================================================
 // Date Created:		16 February 2011
-// Last Updated:		29 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			MimeIdentifier.cpp
 // Programmer:			Matthew Hydock
 //
 // File description:	A class that identifies the mime-type of a file. Used to
-//						be a custom build, now a wrapper for libmagic.
+//						be a custom build, now a wrapper for libmagic. Keeps one
+//						loaded libmagic handle per thread.
 //==============================================================================
 
 #include <fstream>
@@ -21,20 +22,90 @@ void MimeIdentifier::buildDefaultAppsList()
 	string line;
 	vector<string>* toks = NULL;
 	
-	// Begin reading lines and looking for the appropriate type.
+	// Begin reading lines and looking for the appropriate type. Skip the
+	// section header. If the file doesn't exist, there's nothing to read.
 	getline(default_file,line);
-	getline(default_file,line);
-	while (!default_file.eof())
+	while (getline(default_file,line))
 	{
 		toks = tokenizeV(line,"=");
 
-		if (toks != NULL) default_apps.push_back(*toks);
-		
-		getline(default_file,line);
+		if (toks != NULL && toks->size() > 1) default_apps.push_back(*toks);
+		if (toks != NULL) delete toks;
 	}
 	
 	default_file.close();
 }
+
+magic_t MimeIdentifier::getCookie()
+// Get the calling thread's libmagic handle. A thread that doesn't have one yet
+// takes one from the pool, or loads a new one if the pool is empty.
+{
+	Cookie* c = (Cookie*)pthread_getspecific(cookie_key);
+	
+	if (c != NULL)
+		return c->magic;
+	
+	pthread_mutex_lock(&pool_lock);
+	if (!free_cookies.empty())
+	{
+		c = free_cookies.front();
+		free_cookies.pop_front();
+	}
+	pthread_mutex_unlock(&pool_lock);
+	
+	if (c == NULL)
+	{
+		c = new Cookie;
+		c->owner = this;
+		
+		/*MAGIC_MIME tells magic to return a mime of the file, but you can specify different things*/
+		c->magic = magic_open(MAGIC_MIME);
+
+		if (c->magic == NULL)
+		{
+			printf("unable to initialize magic library\n");
+			exit(1);
+		}
+
+		if (magic_load(c->magic, NULL) != 0)
+		{
+			printf("cannot load magic database - %s\n", magic_error(c->magic));
+			magic_close(c->magic);
+			exit(1);
+		}
+		
+		pthread_mutex_lock(&pool_lock);
+		all_cookies.push_back(c);
+		pthread_mutex_unlock(&pool_lock);
+	}
+	
+	pthread_setspecific(cookie_key,c);
+	
+	return c->magic;
+}
+
+void MimeIdentifier::releaseCookie(void* c)
+// Called when a thread that holds a handle exits. Puts the handle back in the
+// pool, rather than closing it.
+{
+	Cookie* cookie = (Cookie*)c;
+	MimeIdentifier* owner = cookie->owner;
+	
+	pthread_mutex_lock(&owner->pool_lock);
+	owner->free_cookies.push_back(cookie);
+	pthread_mutex_unlock(&owner->pool_lock);
+}
+
+void* MimeIdentifier::classifyWorker(void* j)
+// Thread body for classify(). Identifies one slice of the batch.
+{
+	ClassifyJob* job = (ClassifyJob*)j;
+	
+	for (size_t i = job->begin; i < job->end; i++)
+		job->types->at(i) = job->owner->setFileType(job->paths->at(i));
+	
+	return NULL;
+}
 //==============================================================================
 
 
@@ -47,27 +118,12 @@ string MimeIdentifier::setFileType(string pathname)
 {
 //	cout << pathname << endl;
 	
-	magic_t magic_cookie;
+	const char* result = magic_file(getCookie(), pathname.c_str());
 	
-	/*MAGIC_MIME tells magic to return a mime of the file, but you can specify different things*/
-	magic_cookie = magic_open(MAGIC_MIME);
-
-	if (magic_cookie == NULL)
-	{
-		printf("unable to initialize magic library\n");
-		exit(1);
-	}
-
-	if (magic_load(magic_cookie, NULL) != 0)
-	{
-		printf("cannot load magic database - %s\n", magic_error(magic_cookie));
-		magic_close(magic_cookie);
-		exit(1);
-	}
-
-	string temp = magic_file(magic_cookie, pathname.c_str());
-		
-	magic_close(magic_cookie);
+	if (result == NULL)
+		return "";
+	
+	string temp = result;
 	
 	return temp.substr(0,temp.find_first_of(';'));
 }
@@ -112,8 +168,67 @@ enum filetype MimeIdentifier::enumFileType(string mime_type)
 // Public methods.
 //==============================================================================
 MimeIdentifier::MimeIdentifier()
-// Build the defaults list.
+// Build the defaults list, and set up the handle pool.
 {
+	pthread_key_create(&cookie_key,releaseCookie);
+	pthread_mutex_init(&pool_lock,NULL);
+	
 	buildDefaultAppsList();
 }
+
+MimeIdentifier::~MimeIdentifier()
+// Close every libmagic handle that was ever loaded.
+{
+	pthread_key_delete(cookie_key);
+	
+	for (list<Cookie*>::iterator i = all_cookies.begin(); i != all_cookies.end(); i++)
+	{
+		magic_close((*i)->magic);
+		delete *i;
+	}
+	
+	pthread_mutex_destroy(&pool_lock);
+}
+
+vector<string>* MimeIdentifier::classify(vector<string>* paths, int threads)
+// Identify the mime-types of a whole batch of files, splitting the batch
+// between several threads (zero for one per processor). The types come back in
+// the same order as the paths. The caller owns the returned vector.
+{
+	vector<string>* types = new vector<string>(paths->size(),"");
+	
+	if (threads <= 0)
+		threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (threads <= 0)
+		threads = 1;
+	if ((size_t)threads > paths->size())
+		threads = paths->size();
+	if (threads == 0)
+		return types;
+	
+	vector<ClassifyJob> jobs(threads);
+	vector<pthread_t> workers(threads);
+	size_t slice = (paths->size()+threads-1)/threads;
+	
+	for (int i = 0; i < threads; i++)
+	{
+		jobs[i].owner = this;
+		jobs[i].paths = paths;
+		jobs[i].types = types;
+		jobs[i].begin = min(paths->size(),i*slice);
+		jobs[i].end = min(paths->size(),(i+1)*slice);
+	}
+	
+	// The calling thread takes the first slice itself, so a batch on one
+	// thread doesn't spawn anything.
+	for (int i = 1; i < threads; i++)
+		pthread_create(&workers[i],NULL,classifyWorker,&jobs[i]);
+	
+	classifyWorker(&jobs[0]);
+	
+	for (int i = 1; i < threads; i++)
+		pthread_join(workers[i],NULL);
+	
+	return types;
+}
 //==============================================================================
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		15 February 2011
-// Last Updated:		26 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			Star.cpp
 // Programmer:			Matthew Hydock
@@ -26,8 +26,6 @@ Star::Star(FileNode* f)
 	
 	recalc();
 	
-	label = NULL;
-	
 	if (star_texture == NULL)	star_texture = new TextureObject("./images/star2.png");
 }
 
@@ -43,13 +41,20 @@ Star::~Star()
 void Star::calculateRadius()
 // Set the radius of the star based on the size of the file.
 {
-	radius = log10((float)(file->getAttributes().st_size)+1)/log10(1000.0) + 1;
+	radius = log10((float)(file->getSize())+1)/log10(1000.0) + 1;
 	diameter = radius * 2;
 }
 
 void Star::determineColor()
-// Uses the attached file's type to set the star's color.
+// Uses the attached file's type to set the star's color. Files that haven't
+// been typed yet are grey until they are.
 {
+	if (!file->hasType())
+	{
+		setColorArray(color,0.4,0.4,0.4,1.0);
+		return;
+	}
+	
 	switch (file->getMimeEnum())
 	{
 		case BIN:		setColorArray(color,0.0,0.0,1.0,1.0);		// blue
@@ -130,6 +135,12 @@ string Star::getName()
 	return file->getName();
 }
 
+FileNode* Star::getFile()
+// Get the file the star stands for.
+{
+	return file;
+}
+
 float Star::getRadius()
 // Get the radius of the star.
 {
@@ -159,25 +170,49 @@ float Star::getDepth()
 {
 	return depth;
 }
+
+float* Star::getColor()
+// Get the color of the star.
+{
+	return color;
+}
+
+TextureObject* Star::getTexture()
+// Get the texture every star is drawn with.
+{
+	return star_texture;
+}
 //==============================================================================
 
 
 //==============================================================================
 // Convenience methods.
 //==============================================================================
-void Star::randomPosition(float a1, float a2, float dis1, float dis2, float dep1, float dep2)
-// Generate and assign a random position to this star within user defined ranges
+void Star::randomPosition(MTRand* r, float a1, float a2, float dis1, float dis2, float dep1, float dep2)
+// Generate and assign a random position to this star within user defined
+// ranges, using the given generator.
 {
-	MTRand mtrand;
-	
-	angle		= mtrand.rand(a2-a1)+a1;
-	distance	= mtrand.rand(dis2-dis1)+dis1;
-	depth		= mtrand.rand(dep2-dep1)+dep1;
+	angle		= r->rand(a2-a1)+a1;
+	distance	= r->rand(dis2-dis1)+dis1;
+	depth		= r->rand(dep2-dep1)+dep1;
 	
 	xPos = distance*cos(angle*M_PI/180);
 	yPos = distance*sin(angle*M_PI/180);
 }
 
+void Star::randomPositions(MTRand* r, int n, float a1, float a2, float dis1, float dis2, float dep1, float dep2, float* a, float* dis, float* dep)
+// Generate random positions for n stars at once, within user defined ranges,
+// filling in the given arrays. The numbers are drawn in the same order as n
+// calls to randomPosition() would draw them.
+{
+	for (int i = 0; i < n; i++)
+	{
+		a[i]	= r->rand(a2-a1)+a1;
+		dis[i]	= r->rand(dis2-dis1)+dis1;
+		dep[i]	= r->rand(dep2-dep1)+dep1;
+	}
+}
+
 void Star::setPosition(float a, float dis, float dep)
 // Manually set the position of the star.
 {
@@ -244,13 +279,18 @@ void Star::setPointDrawMode()
 	draw_textured = false;
 }
 
+bool Star::isTexturedDrawMode()
+{
+	return draw_textured;
+}
+
 void Star::draw()
 // Default draw function.
 {
-//	if (draw_textured)
+	if (draw_textured)
 		drawTextured();
-//	else
-//		drawPoint();
+	else
+		drawPoint();
 }
 
 void Star::drawTextured()
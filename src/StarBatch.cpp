@@ -0,0 +1,347 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			StarBatch.cpp
+// Programmer:			Matthew Hydock
+//
+// File description:	Draws a galaxy's stars in a single call. Each star is a
+//						textured quad, worked out the same way Star::drawTextured
+//						does with the matrix stack, but done once on the CPU and
+//						kept until the stars change. In point draw mode, each
+//						star is a single point instead, drawn as a sprite with
+//						the star texture, a call per star size.
+//==============================================================================
+
+#include "StarBatch.h"
+
+#include <stdio.h>
+
+//==============================================================================
+// Constructor/Deconstructor
+//==============================================================================
+StarBatch::StarBatch()
+// Make an empty batch. Nothing is sent to the GL until there are stars.
+{
+	sprites = false;
+
+	vbo = 0;
+	checked = false;
+	use_vbo = false;
+	use_point_sprites = false;
+}
+
+StarBatch::~StarBatch()
+{
+	if (vbo != 0)
+		glDeleteBuffers(1,&vbo);
+}
+//==============================================================================
+
+
+//==============================================================================
+// Private methods.
+//==============================================================================
+bool StarBatch::needsPacking(list<GSector*>* sectors)
+// The batch is out of date if the sectors have changed, or any of their stars
+// have, or the stars' draw mode has.
+{
+	if (sprites == Star::isTexturedDrawMode() || sectors->size() != packed.size())
+		return true;
+
+	size_t k = 0;
+	for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++, k++)
+		if (*i != packed[k] || (*i)->starsChanged())
+			return true;
+
+	return false;
+}
+
+void StarBatch::pack(list<GSector*>* sectors)
+// Build the quads (or points) for every star. Quads go sector by sector, in the
+// order they would have been drawn one at a time. Whichever array isn't being
+// used is let go of, as a big galaxy's can be large.
+{
+	sprites = !Star::isTexturedDrawMode();
+
+	if (sprites)
+	{
+		vector<StarVertex>().swap(vertices);
+		packPoints(sectors);
+	}
+	else
+	{
+		vector<StarPoint>().swap(points);
+		runs.clear();
+
+		size_t n = 0;
+		for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++)
+			n += (*i)->getStars()->size();
+
+		vertices.clear();
+		vertices.reserve(n*4);
+
+		for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++)
+		{
+			list<Star*>* stars = (*i)->getStars();
+			for (list<Star*>::iterator j = stars->begin(); j != stars->end(); j++)
+				addStar(*j);
+		}
+	}
+
+	packed.clear();
+	for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++)
+	{
+		(*i)->markStarsDrawn();
+		packed.push_back(*i);
+	}
+}
+
+void StarBatch::packPoints(list<GSector*>* sectors)
+// Build a point for every star, sorted by size with a counting sort, so that
+// each run of same-sized points can be drawn at once.
+{
+	vector<Star*> stars;
+	vector<int> bins;
+	vector<int> counts;
+
+	for (list<GSector*>::iterator i = sectors->begin(); i != sectors->end(); i++)
+	{
+		list<Star*>* s = (*i)->getStars();
+		for (list<Star*>::iterator j = s->begin(); j != s->end(); j++)
+		{
+			int b = max(0,(int)((*j)->getDiameter()/STARBATCH_SIZE_STEP));
+
+			if (b >= (int)counts.size())
+				counts.resize(b+1,0);
+
+			counts[b]++;
+			stars.push_back(*j);
+			bins.push_back(b);
+		}
+	}
+
+	// Work out where each run starts, and note the runs that have points.
+	vector<int> next(counts.size());
+	int first = 0;
+	runs.clear();
+
+	for (size_t b = 0; b < counts.size(); b++)
+	{
+		next[b] = first;
+		first += counts[b];
+
+		if (counts[b] > 0)
+			runs.push_back(make_pair((b+0.5f)*(float)STARBATCH_SIZE_STEP,counts[b]));
+	}
+
+	points.resize(stars.size());
+
+	for (size_t k = 0; k < stars.size(); k++)
+	{
+		Star* s = stars[k];
+		float dis = s->getDistance();
+		float* color = s->getColor();
+
+		StarPoint& p = points[next[bins[k]]++];
+		for (int c = 0; c < 4; c++)
+			p.color[c] = (GLubyte)(color[c]*255+0.5);
+		p.x = dis*cos(s->getAngle()*M_PI/180);
+		p.y = dis*sin(s->getAngle()*M_PI/180);
+		p.z = s->getDepth();
+	}
+}
+
+void StarBatch::addStar(Star* s)
+// Add the four corners of a star's quad. The quad sits on the star's distance
+// along the x axis, is rotated by the star's angle, and is pushed back by its
+// depth, with texture coordinates matching Drawable::drawQuad.
+{
+	float r = s->getRadius();
+	float dis = s->getDistance();
+	float c = cos(s->getAngle()*M_PI/180);
+	float sn = sin(s->getAngle()*M_PI/180);
+
+	float* color = s->getColor();
+	GLubyte rgba[4];
+	for (int k = 0; k < 4; k++)
+		rgba[k] = (GLubyte)(color[k]*255+0.5);
+
+	static const float corners[4][4] =
+	{
+		// x, y, s, t
+		{-1, 1, 0, 0},
+		{-1,-1, 0, 1},
+		{ 1,-1, 1, 1},
+		{ 1, 1, 1, 0}
+	};
+
+	for (int k = 0; k < 4; k++)
+	{
+		float x = dis + corners[k][0]*r;
+		float y = corners[k][1]*r;
+
+		StarVertex v;
+		v.s = corners[k][2];
+		v.t = corners[k][3];
+		memcpy(v.color,rgba,sizeof(rgba));
+		v.x = x*c - y*sn;
+		v.y = x*sn + y*c;
+		v.z = s->getDepth();
+
+		vertices.push_back(v);
+	}
+}
+
+void StarBatch::upload()
+// Copy the vertices (or points) into the vertex buffer, making it first if
+// need be.
+{
+	if (!checked)
+	{
+		use_vbo = hasVersion(1,5);
+		use_point_sprites = hasVersion(2,0);
+		checked = true;
+	}
+
+	if (!use_vbo)
+		return;
+
+	if (vbo == 0)
+		glGenBuffers(1,&vbo);
+
+	glBindBuffer(GL_ARRAY_BUFFER,vbo);
+	if (sprites)
+		glBufferData(GL_ARRAY_BUFFER,points.size()*sizeof(StarPoint),points.empty() ? NULL : &points[0],GL_STATIC_DRAW);
+	else
+		glBufferData(GL_ARRAY_BUFFER,vertices.size()*sizeof(StarVertex),vertices.empty() ? NULL : &vertices[0],GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER,0);
+}
+
+bool StarBatch::hasVersion(int major, int minor)
+// Whether the current context is at least the given OpenGL version. Vertex
+// buffers are core from 1.5 on, and point sprites from 2.0. Mesa's software
+// renderers have both, but an indirect context can report an older version,
+// in which case the plainer ways of drawing are used.
+{
+	const char* version = (const char*)glGetString(GL_VERSION);
+	int have_major = 0;
+	int have_minor = 0;
+
+	if (version == NULL || sscanf(version,"%d.%d",&have_major,&have_minor) != 2)
+		return false;
+
+	return have_major > major || (have_major == major && have_minor >= minor);
+}
+//==============================================================================
+
+
+//==============================================================================
+// Public methods.
+//==============================================================================
+bool StarBatch::update(list<GSector*>* sectors)
+// Pack the stars again if any of them have changed since last time, or the
+// draw mode has. Needs a current GL context. Returns true if the batch was
+// rebuilt.
+{
+	if (!needsPacking(sectors))
+		return false;
+
+	pack(sectors);
+	upload();
+
+	return true;
+}
+
+int StarBatch::getNumStars()
+{
+	return sprites ? points.size() : vertices.size()/4;
+}
+
+void StarBatch::draw(float scale)
+// Draw every star, blended the same way each star was on its own. The scale
+// is how many pixels a galaxy unit covers, which point sizes are given in.
+{
+	if (getNumStars() == 0)
+		return;
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+		if (use_vbo)
+			glBindBuffer(GL_ARRAY_BUFFER,vbo);
+
+		if (sprites)
+			drawPoints(scale);
+		else
+			drawQuads();
+
+		if (use_vbo)
+			glBindBuffer(GL_ARRAY_BUFFER,0);
+	glPopClientAttrib();
+
+	glDisable(GL_BLEND);
+}
+//==============================================================================
+
+
+//==============================================================================
+// Drawing helpers. The vertex buffer, if any, is already bound.
+//==============================================================================
+void StarBatch::drawQuads()
+// Draw every star's quad with the star texture.
+{
+	TextureObject* tex = Star::getTexture();
+	if (tex != NULL)
+		tex->loadTexture();
+
+	glInterleavedArrays(GL_T2F_C4UB_V3F,sizeof(StarVertex),use_vbo ? NULL : &vertices[0]);
+	glDrawArrays(GL_QUADS,0,vertices.size());
+
+	if (tex != NULL)
+		tex->unloadTexture();
+}
+
+void StarBatch::drawPoints(float scale)
+// Draw every star as a point sprite with the star texture, one call per run of
+// same-sized stars. Without point sprites, they are round points, the way
+// Star::drawPoint draws them.
+{
+	TextureObject* tex = Star::getTexture();
+
+	if (use_point_sprites)
+	{
+		glEnable(GL_POINT_SPRITE);
+		glTexEnvi(GL_POINT_SPRITE,GL_COORD_REPLACE,GL_TRUE);
+
+		if (tex != NULL)
+			tex->loadTexture();
+	}
+	else
+		glEnable(GL_POINT_SMOOTH);
+
+	glInterleavedArrays(GL_C4UB_V3F,sizeof(StarPoint),use_vbo ? NULL : &points[0]);
+
+	int first = 0;
+	for (size_t k = 0; k < runs.size(); k++)
+	{
+		glPointSize(max(runs[k].first*scale,1.0f));
+		glDrawArrays(GL_POINTS,first,runs[k].second);
+		first += runs[k].second;
+	}
+
+	glPointSize(1);
+
+	if (use_point_sprites)
+	{
+		glTexEnvi(GL_POINT_SPRITE,GL_COORD_REPLACE,GL_FALSE);
+		glDisable(GL_POINT_SPRITE);
+
+		if (tex != NULL)
+			tex->unloadTexture();
+	}
+	else
+		glDisable(GL_POINT_SMOOTH);
+}
+//==============================================================================
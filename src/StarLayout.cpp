@@ -0,0 +1,209 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			StarLayout.cpp
+// Programmer:			Matthew Hydock
+//
+// File description:	Remembers where the stars in a galaxy were placed, one
+//						record per file, and saves them to a small binary file
+//						in the cache directory. Each galaxy root and clustering
+//						mode gets a file of its own.
+//==============================================================================
+
+#include "StarLayout.h"
+#include "IndexSnapshot.h"
+
+//==============================================================================
+// Constructor
+//==============================================================================
+StarLayout::StarLayout(string p)
+// Make an empty layout for the given file. Nothing is read until load().
+{
+	path = p;
+	changed = false;
+}
+//==============================================================================
+
+
+//==============================================================================
+// Loading and saving.
+//==============================================================================
+bool StarLayout::load()
+// Read the layout file. Returns false if there is no layout yet, or it can't
+// be used, in which case the layout is left empty.
+{
+	places.clear();
+	changed = false;
+
+	FILE* in = fopen(path.c_str(),"rb");
+	if (in == NULL)
+		return false;
+
+	LayoutHeader h;
+	vector<LayoutStar> recs;
+
+	bool ok = fread(&h,sizeof(h),1,in) == 1;
+	ok = ok && memcmp(h.magic,LAYOUT_MAGIC,sizeof(h.magic)) == 0 && h.version == LAYOUT_VERSION;
+
+	if (ok && h.num_stars > 0)
+	{
+		recs.resize(h.num_stars);
+		ok = fread(&recs[0],sizeof(LayoutStar),recs.size(),in) == recs.size();
+	}
+
+	fclose(in);
+
+	if (!ok)
+	{
+		cout << "WARNING: Ignoring unreadable star layout " << path << endl;
+		return false;
+	}
+
+	for (size_t i = 0; i < recs.size(); i++)
+	{
+		StarPlace p;
+		p.angle		= recs[i].angle;
+		p.distance	= recs[i].distance;
+		p.depth		= recs[i].depth;
+		p.seen		= false;
+		places[recs[i].key] = p;
+	}
+
+	return true;
+}
+
+bool StarLayout::save()
+// Write out the places of the stars recorded since the layout was loaded. The
+// file is written under a temporary name then renamed, like the index
+// snapshot. Nothing is written if nothing has moved.
+{
+	vector<LayoutStar> recs;
+	recs.reserve(places.size());
+
+	for (tr1::unordered_map<uint64_t,StarPlace>::iterator i = places.begin(); i != places.end(); i++)
+		if (i->second.seen)
+		{
+			LayoutStar s;
+			s.key		= i->first;
+			s.angle		= i->second.angle;
+			s.distance	= i->second.distance;
+			s.depth		= i->second.depth;
+			s.unused	= 0;
+			recs.push_back(s);
+		}
+
+	// Files that are gone (or weren't in the galaxy this time) count as a
+	// change too, so they don't pile up.
+	if (!changed && recs.size() == places.size())
+		return true;
+
+	LayoutHeader h;
+	memset(&h,0,sizeof(h));
+	memcpy(h.magic,LAYOUT_MAGIC,sizeof(h.magic));
+	h.version	= LAYOUT_VERSION;
+	h.num_stars	= recs.size();
+
+	string temp_path = path + ".tmp";
+	FILE* out = fopen(temp_path.c_str(),"wb");
+	if (out == NULL)
+	{
+		cout << "WARNING: Could not write star layout " << temp_path << endl;
+		return false;
+	}
+
+	bool ok = fwrite(&h,sizeof(h),1,out) == 1;
+	if (!recs.empty())
+		ok = ok && fwrite(&recs[0],sizeof(LayoutStar),recs.size(),out) == recs.size();
+	ok = (fclose(out) == 0) && ok;
+
+	if (!ok || rename(temp_path.c_str(),path.c_str()) != 0)
+	{
+		cout << "WARNING: Could not write star layout " << path << endl;
+		unlink(temp_path.c_str());
+		return false;
+	}
+
+	// The file now matches what was recorded.
+	for (tr1::unordered_map<uint64_t,StarPlace>::iterator i = places.begin(); i != places.end();)
+	{
+		if (i->second.seen)
+			i++;
+		else
+			places.erase(i++);
+	}
+
+	changed = false;
+
+	return true;
+}
+//==============================================================================
+
+
+//==============================================================================
+// Looking up and recording places.
+//==============================================================================
+bool StarLayout::find(FileNode* f, float* a, float* dis, float* dep)
+// Look up where a file's star was last time. Returns false if it has never
+// been placed.
+{
+	tr1::unordered_map<uint64_t,StarPlace>::iterator i = places.find(keyFor(f));
+
+	if (i == places.end())
+		return false;
+
+	*a = i->second.angle;
+	*dis = i->second.distance;
+	*dep = i->second.depth;
+
+	return true;
+}
+
+void StarLayout::record(FileNode* f, float a, float dis, float dep)
+// Remember where a file's star is now.
+{
+	uint64_t key = keyFor(f);
+	tr1::unordered_map<uint64_t,StarPlace>::iterator i = places.find(key);
+
+	if (i == places.end())
+	{
+		changed = true;
+		i = places.insert(make_pair(key,StarPlace())).first;
+	}
+	else if (i->second.angle != a || i->second.distance != dis || i->second.depth != dep)
+		changed = true;
+
+	StarPlace& p = i->second;
+	p.angle = a;
+	p.distance = dis;
+	p.depth = dep;
+	p.seen = true;
+}
+
+int StarLayout::getNumStars()
+{
+	return places.size();
+}
+//==============================================================================
+
+
+//==============================================================================
+// Naming.
+//==============================================================================
+uint64_t StarLayout::keyFor(FileNode* f)
+// A file is known by a 64-bit hash of its path, so big galaxies don't run into
+// collisions.
+{
+	return hashString64(f->getPath() + f->getName());
+}
+
+string StarLayout::pathFor(string root, int mode)
+// Work out where the layout for the given galaxy root and clustering mode
+// lives. Layouts are named like index snapshots, with the mode added on.
+{
+	char name[40];
+	snprintf(name,sizeof(name),"%016llx-%d.lay",hashString64(root),mode);
+
+	return IndexSnapshot::cacheDirectory() + "/" + name;
+}
+//==============================================================================
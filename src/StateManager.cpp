@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		6 April 2011
-// Last Updated:		29 March 2012
+// Last Updated:		18 October 2026
 //
 // File name:			StateManager.h
 // Programmer:			Matthew Hydock
@@ -16,10 +16,15 @@
 //==============================================================================
 // Constructor/Deconstructor.
 //==============================================================================
-StateManager::StateManager(string dir)
-// Make a new galactic state manager.
+StateManager::StateManager(string dir, int threads, bool rebuild)
+// Make a new galactic state manager, indexing with the given number of worker
+// threads (zero for one per processor). The saved index is used unless a
+// rebuild is asked for. Indexing goes on in the background, and the first
+// galaxy fills in as it goes.
 {
-	indexer = new Indexer(dir);
+	indexer = new Indexer(dir,threads,rebuild,true);
+	watcher = NULL;
+	revision = 0;
 	
 	Galaxy* temp = new Galaxy(indexer->getDirectoryTree()->getRootNode());	
 	galaxies.push_back(temp);
@@ -30,6 +35,8 @@ StateManager::StateManager(string dir)
 StateManager::~StateManager()
 // Clean up after the galactic state manager.
 {
+	if (watcher != NULL)
+		delete(watcher);
 	delete(indexer);
 	
 	for (curr = galaxies.begin(); curr != galaxies.end(); curr++)
@@ -81,15 +88,25 @@ void StateManager::navigate()
 		DirNode* dir = selected->getDirectory();
 		Galaxy* temp;
 		
-		if (dir != NULL)
+		// A sector that stands in for several small directories opens them
+		// all, each as a sector of its own.
+		if (selected->isAggregate())
+		{
+			cout << "Creating a new galaxy called " << selected->getName() << endl;
+			temp = new Galaxy(selected->getMembers(),(*curr)->getClusterMode(),(*curr)->getName() + " - " + selected->getName());
+		}
+		else if (dir != NULL)
 		{
 			cout << "Creating a new galaxy called " << dir->getName() << endl;
 			temp = new Galaxy(dir,NULL,(*curr)->getClusterMode());
 		}
 		else
 		{
-			list<FileNode*>* files = selected->getFileList();
+			// The sector's list goes when the sector does, so the new galaxy
+			// gets a copy of its own.
+			list<FileNode*>* files = new list<FileNode*>(*selected->getFileList());
 			temp = new Galaxy(NULL,files,NONE,(*curr)->getName());
+			temp->adoptFileList();
 		}
 		
 		galaxies.push_back(temp);
@@ -97,6 +114,71 @@ void StateManager::navigate()
 	}
 }
 
+bool StateManager::update()
+// Collect whatever the indexer has found since last time, or once indexing is
+// done, whatever has changed in the file system, and patch every galaxy in
+// the history to match. Galaxies for directories that are gone are dropped;
+// if the current one goes, the one before it is shown instead. When there is
+// nothing to collect, the current galaxy's files have their metadata read, a
+// batch at a time. Returns true if anything was done, in which case the screen
+// may be out of date, and there may well be more to do straight away.
+{
+	TreeChanges* changes = NULL;
+	
+	if (indexer->isBuilding())
+		changes = indexer->collect();
+	else if (watcher == NULL)
+		watcher = new TreeWatcher(indexer);
+	else
+		changes = watcher->poll();
+	
+	// With nothing new, spend the time reading the metadata of the files in
+	// the galaxy being shown.
+	if (changes == NULL)
+		return (*curr)->prefetch(PREFETCH_BATCH) > 0;
+	
+	list<Galaxy*>::iterator i = galaxies.begin();
+	while (i != galaxies.end())
+	{
+		if ((*i)->applyChanges(changes))
+		{
+			i++;
+			continue;
+		}
+		
+		cout << "Dropping galaxy " << (*i)->getName() << ", its directory is gone" << endl;
+		
+		if (i == curr)
+			curr--;
+		
+		delete *i;
+		i = galaxies.erase(i);
+	}
+	
+	revision++;
+	
+	// The galaxies have let go of everything removed, so it can be deleted.
+	delete changes;
+	
+	return true;
+}
+
+bool StateManager::animate(float dt)
+// Move the current galaxy on by dt seconds. Returns true if it moved.
+{
+	return (*curr)->animate(dt);
+}
+
+int StateManager::getRevision()
+{
+	return revision;
+}
+
+Indexer* StateManager::getIndexer()
+{
+	return indexer;
+}
+
 void StateManager::setActiveTags(list<string>* t)
 {
 	tags = t;
@@ -127,6 +209,34 @@ void StateManager::deleteFuture()
 //==============================================================================
 // Methods to change the clustering mode of the current set.
 //==============================================================================
+void StateManager::showClustered(cluster_type m)
+// Make a new galaxy out of the current one's files, clustered the given way,
+// and navigate to it. Nothing happens if the current galaxy is already
+// clustered that way.
+{
+	Galaxy* now = *curr;
+	
+	if (now->getClusterMode() == m)
+		return;
+	
+	deleteFuture();
+	
+	Galaxy* temp;
+	
+	if (now->getDirectory() != NULL)
+		temp = new Galaxy(now->getDirectory(),NULL,m);
+	else if (!now->getMembers()->empty())
+		temp = new Galaxy(now->getMembers(),m,now->getName());
+	else
+	{
+		temp = new Galaxy(NULL,new list<FileNode*>(*now->getFileList()),m,now->getName());
+		temp->adoptFileList();
+	}
+	
+	galaxies.push_back(temp);
+	curr++;
+}
+
 void StateManager::setDirectoryMode()
 // Backtrack until the current galaxy is in directory mode.
 {
@@ -135,16 +245,28 @@ void StateManager::setDirectoryMode()
 }
 
 void StateManager::setNameMode()
-{}
+// Show the current galaxy's files clustered by name.
+{
+	showClustered(NAME);
+}
 
 void StateManager::setDateMode()
-{}
+// Show the current galaxy's files clustered by date.
+{
+	showClustered(DATE);
+}
 
 void StateManager::setSizeMode()
-{}
+// Show the current galaxy's files clustered by size.
+{
+	showClustered(SIZE);
+}
 
 void StateManager::setTypeMode()
-{}
+// Show the current galaxy's files clustered by type.
+{
+	showClustered(TYPE);
+}
 
 void StateManager::setTagsMode()
 {
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		6 May 2011
-// Last Updated:		16 May 2011
+// Last Updated:		18 October 2026
 //
 // File name:			StatusBar.cpp
 // Programmer:			Matthew Hydock
@@ -49,24 +49,27 @@ void StatusBar::refreshState()
 {
 	ostringstream oss;
 	curr = state->getCurrent();
+	revision = state->getRevision();
 	int num;
 	
-	DirNode* dir = curr->getDirectory();
-	if (dir == NULL)
-	{
-//		cout << "dir is null, using filelist\n";
-		num = curr->getFileList()->size();
-//		cout << "got num files: " << num << endl;
-	}
+	// A galaxy on a directory can use the directory's totals. Otherwise, its
+	// file list is kept up to date as the tree changes.
+	if (curr->getDirectory() != NULL)
+		num = curr->getDirectory()->getTotals()->files;
 	else
-	{
-//		cout << "dir is " << curr->getDirectory()->name << endl;
-		num = curr->getDirectory()->getAllFiles()->size();
-//		cout << "got num files: " << num << endl;
-	}
+		num = curr->getFileList()->size();
 
 	oss << " Files: " << num;
 	
+	// While indexing, show how it's going.
+	Indexer* indexer = state->getIndexer();
+	if (indexer->isBuilding())
+	{
+		oss << " | Indexed: " << indexer->getFilesFound();
+		oss << ", " << indexer->getDirsPending() << " dirs left";
+		oss << ", " << indexer->getFilesPerSecond() << " files/s";
+	}
+	
 	directory->setText(curr->getName());
 	num_files->setText(oss.str());
 	
@@ -80,7 +83,7 @@ void StatusBar::refreshState()
 	
 void StatusBar::draw()
 {
-	if (curr != state->getCurrent())
+	if (curr != state->getCurrent() || revision != state->getRevision())
 		refreshState();
 	
 	// Set the position of the labels, based on the viewport.
@@ -1,6 +1,6 @@
 //==============================================================================
 // Date Created:		13 May 2011
-// Last Updated:		17 May 2011
+// Last Updated:		18 October 2026
 //
 // File name:			TagsList.cpp
 // Programmer:			Matthew Hydock
@@ -123,6 +123,11 @@ void TagsList::draw()
 		curr = temp;
 		rebuildTags();
 	}
+	else if (curr->getTags()->size() != drawables->size())
+	{
+		// The galaxy finds more tags as its files are read.
+		rebuildTags();
+	}
 	
 	DrawableList::draw();
 }
@@ -0,0 +1,363 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			TreeArena.cpp
+// Programmer:			Matthew Hydock
+//
+// File description:	Implementation of a flat store of the directory tree's
+//						metadata, kept in columns, and laid out in preorder so
+//						that whole subtrees can be scanned as runs of rows.
+//==============================================================================
+
+#include "TreeArena.h"
+#include "DirNode.h"
+
+//==============================================================================
+// Constructor.
+//==============================================================================
+TreeArena::TreeArena()
+// Start out empty, with only the mime-type for files that haven't been typed.
+{
+	live = 0;
+	laid_out = false;
+
+	MimeType none;
+	none.type = NULL;
+	none.kind = UNKNOWN;
+	mimes.push_back(none);
+}
+//==============================================================================
+
+
+//==============================================================================
+// Rows, names, and mime-types.
+//==============================================================================
+int TreeArena::allocate(FileNode* f, string n)
+// Give a new file a row, reusing one that has been let go if there is one.
+// Everything but the name starts out empty.
+{
+	int r;
+
+	if (!free_rows.empty())
+	{
+		r = free_rows.back();
+		free_rows.pop_back();
+	}
+	else
+	{
+		r = view.size();
+
+		view.push_back(NULL);
+		name.push_back(0);
+		ino.push_back(0);
+		size.push_back(0);
+		blocks.push_back(0);
+		mtime.push_back(0);
+		ctime.push_back(0);
+		mode.push_back(0);
+		mime.push_back(0);
+		known.push_back(0);
+	}
+
+	view[r] = f;
+	name[r] = addName(n);
+	ino[r] = 0;
+	size[r] = 0;
+	blocks[r] = 0;
+	mtime[r] = 0;
+	ctime[r] = 0;
+	mode[r] = 0;
+	mime[r] = 0;
+	known[r] = 0;
+
+	live++;
+
+	return r;
+}
+
+void TreeArena::release(int r)
+// Let go of a file's row. Its name stays in the block until the next layout.
+{
+	view[r] = NULL;
+	free_rows.push_back(r);
+	live--;
+}
+
+uint32_t TreeArena::addName(string n)
+// Put a name on the end of the block, and give its offset.
+{
+	uint32_t offset = names.size();
+
+	names.insert(names.end(),n.begin(),n.end());
+	names.push_back('\0');
+
+	return offset;
+}
+
+void TreeArena::setName(int r, string n)
+// Give a file a new name. The old one is left in the block until the next
+// layout.
+{
+	name[r] = addName(n);
+}
+
+const char* TreeArena::nameAt(int r)
+{
+	return &names[name[r]];
+}
+
+int TreeArena::findMime(string type)
+// Get the number of a mime-type, or -1 if it hasn't been seen yet.
+{
+	map<string,int>::iterator i = mime_numbers.find(type);
+
+	if (i == mime_numbers.end())
+		return -1;
+
+	return i->second;
+}
+
+int TreeArena::addMime(string type, string app, enum filetype kind)
+// Add a new mime-type, with its default app and kind, and get its number. If
+// there are no numbers left, the type is counted as unknown, rather than its
+// number wrapping around onto another type's.
+{
+	if (mimes.size() >= ARENA_MAX_MIMES-1)
+	{
+		int n = findMime(ARENA_OVERFLOW_MIME);
+		if (n >= 0)
+			return n;
+
+		type = ARENA_OVERFLOW_MIME;
+		app = "";
+		kind = UNKNOWN;
+	}
+
+	map<string,int>::iterator i = mime_numbers.insert(make_pair(type,(int)mimes.size())).first;
+
+	MimeType m;
+	m.type = &i->first;
+	m.app = app;
+	m.kind = kind;
+	mimes.push_back(m);
+
+	return i->second;
+}
+//==============================================================================
+
+
+//==============================================================================
+// Laying out the tree.
+//==============================================================================
+void TreeArena::layOut(DirNode* root)
+// Put the rows of every file below root in preorder: a directory's own files
+// in order, then each sub-directory's subtree in turn. Directories get rows of
+// their own in the same order. Files that aren't in the tree (such as those
+// waiting to be thrown away) go after, and rows that were let go are dropped,
+// along with names that are no longer used. Directories still waiting in a
+// snapshot are laid out empty, as they have no files yet.
+{
+	vector<int> order;
+	order.reserve(live);
+
+	dir_view.clear();
+	dir_parent.clear();
+	dir_first_child.clear();
+	dir_next_sibling.clear();
+	dir_files.clear();
+	dir_files_end.clear();
+	dir_subtree_end.clear();
+
+	if (root != NULL)
+		layDirectory(root,-1,&order);
+
+	vector<char> placed(view.size(),0);
+	for (size_t k = 0; k < order.size(); k++)
+		placed[order[k]] = 1;
+
+	for (size_t r = 0; r < view.size(); r++)
+		if (view[r] != NULL && !placed[r])
+			order.push_back(r);
+
+	// Copy every column over in the new order, and tell each file where its
+	// row went.
+	size_t n = order.size();
+
+	vector<FileNode*> new_view(n);
+	vector<uint32_t> new_name(n);
+	vector<ino_t> new_ino(n);
+	vector<off_t> new_size(n);
+	vector<blkcnt_t> new_blocks(n);
+	vector<time_t> new_mtime(n);
+	vector<time_t> new_ctime(n);
+	vector<mode_t> new_mode(n);
+	vector<uint16_t> new_mime(n);
+	vector<unsigned char> new_known(n);
+	vector<char> new_names;
+
+	for (size_t k = 0; k < n; k++)
+	{
+		int r = order[k];
+
+		new_view[k] = view[r];
+		new_ino[k] = ino[r];
+		new_size[k] = size[r];
+		new_blocks[k] = blocks[r];
+		new_mtime[k] = mtime[r];
+		new_ctime[k] = ctime[r];
+		new_mode[k] = mode[r];
+		new_mime[k] = mime[r];
+		new_known[k] = known[r];
+
+		const char* s = nameAt(r);
+		new_name[k] = new_names.size();
+		new_names.insert(new_names.end(),s,s+strlen(s)+1);
+
+		view[r]->row = k;
+	}
+
+	view.swap(new_view);
+	name.swap(new_name);
+	ino.swap(new_ino);
+	size.swap(new_size);
+	blocks.swap(new_blocks);
+	mtime.swap(new_mtime);
+	ctime.swap(new_ctime);
+	mode.swap(new_mode);
+	mime.swap(new_mime);
+	known.swap(new_known);
+	names.swap(new_names);
+
+	free_rows.clear();
+	laid_out = (root != NULL);
+}
+
+int TreeArena::layDirectory(DirNode* d, int parent, vector<int>* order)
+// Lay out one directory and everything below it. Returns its row.
+{
+	int dr = dir_view.size();
+	d->row = dr;
+
+	dir_view.push_back(d);
+	dir_parent.push_back(parent);
+	dir_first_child.push_back(-1);
+	dir_next_sibling.push_back(-1);
+	dir_files.push_back(order->size());
+
+	for (list<FileNode*>::iterator i = d->files.begin(); i != d->files.end(); i++)
+		order->push_back((*i)->row);
+
+	dir_files_end.push_back(order->size());
+	dir_subtree_end.push_back(0);
+
+	int prev = -1;
+	for (list<DirNode*>::iterator i = d->dirs.begin(); i != d->dirs.end(); i++)
+	{
+		int child = layDirectory(*i,dr,order);
+
+		if (prev < 0)
+			dir_first_child[dr] = child;
+		else
+			dir_next_sibling[prev] = child;
+
+		prev = child;
+	}
+
+	dir_subtree_end[dr] = order->size();
+
+	return dr;
+}
+
+void TreeArena::touch()
+// Note that the shape of the tree has changed, so the layout is out of date.
+{
+	laid_out = false;
+}
+
+bool TreeArena::isLaidOut(DirNode* d)
+// Check if a directory's rows are as the layout says.
+{
+	return laid_out && d->row >= 0 && d->row < (int)dir_view.size() && dir_view[d->row] == d;
+}
+
+int TreeArena::getNumLive()
+// Get how many files have rows.
+{
+	return live;
+}
+//==============================================================================
+
+
+//==============================================================================
+// Reading the columns.
+//==============================================================================
+bool TreeArena::getRange(DirNode* d, int* begin, int* end)
+// Get the run of rows holding every file below a directory. Returns false if
+// the directory isn't laid out.
+{
+	if (!isLaidOut(d))
+		return false;
+
+	*begin = dir_files[d->row];
+	*end = dir_subtree_end[d->row];
+
+	return true;
+}
+
+FileNode* TreeArena::getFile(int r)
+{
+	return view[r];
+}
+
+off_t TreeArena::getSize(int r)
+{
+	return size[r];
+}
+
+blkcnt_t TreeArena::getBlocks(int r)
+{
+	return blocks[r];
+}
+
+time_t TreeArena::getModifiedTime(int r)
+{
+	return mtime[r];
+}
+
+enum filetype TreeArena::getMimeEnum(int r)
+{
+	return (enum filetype)mimes[mime[r]].kind;
+}
+
+int TreeArena::getKnown(int r)
+{
+	return known[r] & FILE_HAVE_ALL;
+}
+
+int TreeArena::getDirRow(DirNode* d)
+// Get a directory's row, or -1 if it isn't laid out.
+{
+	return isLaidOut(d) ? d->row : -1;
+}
+
+DirNode* TreeArena::getDirectory(int dr)
+{
+	return dir_view[dr];
+}
+
+int TreeArena::getParentRow(int dr)
+{
+	return dir_parent[dr];
+}
+
+int TreeArena::getFirstChildRow(int dr)
+{
+	return dir_first_child[dr];
+}
+
+int TreeArena::getNextSiblingRow(int dr)
+{
+	return dir_next_sibling[dr];
+}
+//==============================================================================
@@ -0,0 +1,137 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			TreeChanges.cpp
+// Programmer:			Matthew Hydock
+//
+// File description:	Records the files and directories that were added,
+//						changed, or removed during one refresh of a tree.
+//						Removed nodes are kept alive until the change set is
+//						deleted.
+//==============================================================================
+
+#include "TreeChanges.h"
+
+//==============================================================================
+// Constructor/Deconstructor
+//==============================================================================
+TreeChanges::TreeChanges()
+// Make an empty change set.
+{
+}
+
+TreeChanges::~TreeChanges()
+// Delete everything that was taken out of the tree. Deleting a directory
+// deletes everything below it too.
+{
+	for (list<FileNode*>::iterator i = detached_files.begin(); i != detached_files.end(); i++)
+		delete *i;
+
+	for (list<DirNode*>::iterator i = detached_dirs.begin(); i != detached_dirs.end(); i++)
+		delete *i;
+}
+//==============================================================================
+
+
+//==============================================================================
+// Private methods.
+//==============================================================================
+void TreeChanges::collectRemoved(DirNode* d)
+// Note a removed directory, and everything below it, as removed.
+{
+	removed_dirs.insert(d);
+
+	list<FileNode*>* fl = d->getFiles();
+	for (list<FileNode*>::iterator i = fl->begin(); i != fl->end(); i++)
+		removed.insert(*i);
+
+	list<DirNode*>* dl = d->getDirectories();
+	for (list<DirNode*>::iterator i = dl->begin(); i != dl->end(); i++)
+		collectRemoved(*i);
+}
+//==============================================================================
+
+
+//==============================================================================
+// Recording changes.
+//==============================================================================
+void TreeChanges::addFile(FileNode* f)
+// Note a file that is new to the tree.
+{
+	added.push_back(f);
+}
+
+void TreeChanges::changeFile(FileNode* f)
+// Note a file whose attributes were read again.
+{
+	changed.push_back(f);
+}
+
+void TreeChanges::removeFile(FileNode* f)
+// Note a file that has already been taken out of the tree. The change set now
+// owns it.
+{
+	removed.insert(f);
+	detached_files.push_back(f);
+}
+
+void TreeChanges::addDirectory(DirNode* d)
+// Note a directory that is new to the tree.
+{
+	added_dirs.push_back(d);
+}
+
+void TreeChanges::removeDirectory(DirNode* d)
+// Note a directory that has already been taken out of the tree, along with
+// everything in it. The change set now owns it.
+{
+	collectRemoved(d);
+	detached_dirs.push_back(d);
+}
+//==============================================================================
+
+
+//==============================================================================
+// Getters.
+//==============================================================================
+list<FileNode*>* TreeChanges::getAdded()
+{
+	return &added;
+}
+
+list<FileNode*>* TreeChanges::getChanged()
+{
+	return &changed;
+}
+
+set<FileNode*>* TreeChanges::getRemoved()
+{
+	return &removed;
+}
+
+list<DirNode*>* TreeChanges::getAddedDirectories()
+{
+	return &added_dirs;
+}
+
+set<DirNode*>* TreeChanges::getRemovedDirectories()
+{
+	return &removed_dirs;
+}
+
+bool TreeChanges::isRemoved(FileNode* f)
+{
+	return removed.find(f) != removed.end();
+}
+
+bool TreeChanges::isRemoved(DirNode* d)
+{
+	return removed_dirs.find(d) != removed_dirs.end();
+}
+
+bool TreeChanges::isEmpty()
+{
+	return added.empty() && changed.empty() && removed.empty() && added_dirs.empty() && removed_dirs.empty();
+}
+//==============================================================================
@@ -0,0 +1,343 @@
+//==============================================================================
+// Date Created:		18 October 2026
+// Last Updated:		18 October 2026
+//
+// File name:			TreeWatcher.cpp
+// Programmer:			Matthew Hydock
+//
+// File description:	Watches every directory in an indexed tree with inotify.
+//						Events only mark directories as changed; once things go
+//						quiet, the changed directories are read again all at
+//						once, and the changes handed back to be shown. If the
+//						watch limit is hit, the whole tree is checked every so
+//						often instead.
+//==============================================================================
+
+#include "TreeWatcher.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/time.h>
+
+//==============================================================================
+// Helpers.
+//==============================================================================
+static double now()
+// The current time, in seconds.
+{
+	struct timeval t;
+	gettimeofday(&t,NULL);
+
+	return t.tv_sec + t.tv_usec/1000000.0;
+}
+//==============================================================================
+
+
+//==============================================================================
+// Constructor/Deconstructor
+//==============================================================================
+TreeWatcher::TreeWatcher(Indexer* ix)
+// Start watching the indexer's tree. If inotify isn't available, fall back on
+// checking the whole tree every so often.
+{
+	indexer = ix;
+
+	first_event = 0;
+	last_event = 0;
+	overflowed = false;
+
+	polling = false;
+	last_poll = now();
+
+	fd = inotify_init();
+
+	if (fd < 0)
+	{
+		cout << "WARNING: Could not start watching the file system, checking it every " << WATCH_POLL_INTERVAL << " seconds instead." << endl;
+		polling = true;
+		return;
+	}
+
+	fcntl(fd,F_SETFL,fcntl(fd,F_GETFL) | O_NONBLOCK);
+	fcntl(fd,F_SETFD,FD_CLOEXEC);
+
+	watchTree(indexer->getDirectoryTree()->getRootNode());
+
+	cout << "watching " << getNumWatches() << " directories" << endl;
+}
+
+TreeWatcher::~TreeWatcher()
+// Stop watching. Closing the descriptor drops every watch.
+{
+	if (fd >= 0)
+		close(fd);
+}
+//==============================================================================
+
+
+//==============================================================================
+// Private methods.
+//==============================================================================
+void TreeWatcher::watchTree(DirNode* d)
+// Watch a directory and everything below it. Anything still in the snapshot is
+// watched by its records, so it isn't read out.
+{
+	watchDirectory(d);
+
+	if (d->getSnapshot() != NULL)
+	{
+		watchRecords(d->getSnapshot(),d->getSnapshotIndex(),d->getPath());
+		return;
+	}
+
+	list<DirNode*>* sub = d->getDirectories();
+	for (list<DirNode*>::iterator i = sub->begin(); i != sub->end() && !polling; i++)
+		watchTree(*i);
+}
+
+void TreeWatcher::watchRecords(IndexSnapshot* s, int index, string path)
+// Watch every directory below a snapshot record, by path.
+{
+	const SnapshotDir* sd = s->getDirRecord(index);
+	if (sd == NULL)
+		return;
+
+	for (uint32_t i = 0; i < sd->num_dirs && !polling; i++)
+	{
+		int c = sd->first_dir + i;
+		string p = path + s->getDirName(c) + "/";
+
+		int wd = addWatch(p);
+		if (wd < 0)
+			continue;
+
+		if (watches.find(wd) == watches.end() && record_watches.find(wd) == record_watches.end())
+			record_watches[wd] = p;
+
+		watchRecords(s,c,p);
+	}
+}
+
+void TreeWatcher::watchDirectory(DirNode* d)
+// Watch a single directory. If it was being watched by its path, the watch
+// now goes to its node.
+{
+	if (descriptors.find(d) != descriptors.end())
+		return;
+
+	int wd = addWatch(d->getPath());
+	if (wd < 0)
+		return;
+
+	record_watches.erase(wd);
+
+	// Two paths can lead to the same directory through links, in which case
+	// the kernel hands back the same descriptor. Keep the first.
+	if (watches.find(wd) != watches.end())
+		return;
+
+	watches[wd] = d;
+	descriptors[d] = wd;
+}
+
+int TreeWatcher::addWatch(string path)
+// Ask inotify to watch a directory. Returns the watch descriptor, or -1. Once
+// the watch limit has been hit, there is no point trying again.
+{
+	if (fd < 0 || polling)
+		return -1;
+
+	int wd = inotify_add_watch(fd,path.c_str(),WATCH_EVENTS);
+
+	if (wd < 0 && errno == ENOSPC)
+	{
+		cout << "WARNING: Ran out of inotify watches after " << getNumWatches() << " directories, ";
+		cout << "checking the whole tree every " << WATCH_POLL_INTERVAL << " seconds as well." << endl;
+		polling = true;
+	}
+
+	return wd;
+}
+
+DirNode* TreeWatcher::resolve(int wd)
+// Find the node for a watched directory. One watched by its path is found by
+// following the path down the tree, which reads out only the directories on
+// the way, and from then on is watched by its node. Returns NULL if the
+// directory isn't watched, or is no longer in the tree.
+{
+	map<int,DirNode*>::iterator w = watches.find(wd);
+	if (w != watches.end())
+		return w->second;
+
+	map<int,string>::iterator r = record_watches.find(wd);
+	if (r == record_watches.end())
+		return NULL;
+
+	DirNode* d = indexer->getDirectoryTree()->getDir(r->second);
+	record_watches.erase(r);
+
+	if (d == NULL || descriptors.find(d) != descriptors.end())
+		return d;
+
+	watches[wd] = d;
+	descriptors[d] = wd;
+
+	return d;
+}
+
+void TreeWatcher::forget(DirNode* d)
+// Stop watching a directory that has left the tree. Its watch may already be
+// gone, if the directory was deleted.
+{
+	map<DirNode*,int>::iterator i = descriptors.find(d);
+
+	if (i == descriptors.end())
+		return;
+
+	inotify_rm_watch(fd,i->second);
+	watches.erase(i->second);
+	descriptors.erase(i);
+}
+
+void TreeWatcher::markDirty(DirNode* d)
+// Note that something happened in a directory.
+{
+	if (dirty.empty())
+		first_event = now();
+
+	last_event = now();
+	dirty.insert(d);
+}
+
+void TreeWatcher::readEvents()
+// Read every event waiting, and mark the directories they happened in.
+{
+	// Long, so the buffer is aligned for the event structures.
+	long buf[4096];
+	ssize_t len;
+
+	while ((len = read(fd,buf,sizeof(buf))) > 0)
+	{
+		char* p = (char*)buf;
+
+		while (p < (char*)buf + len)
+		{
+			struct inotify_event* ev = (struct inotify_event*)p;
+			p += sizeof(struct inotify_event) + ev->len;
+
+			// The kernel's queue filled up, and events were lost.
+			if (ev->mask & IN_Q_OVERFLOW)
+			{
+				overflowed = true;
+				continue;
+			}
+
+			// The watch is gone, because the directory was.
+			if (ev->mask & IN_IGNORED)
+			{
+				map<int,DirNode*>::iterator w = watches.find(ev->wd);
+				if (w != watches.end())
+				{
+					descriptors.erase(w->second);
+					watches.erase(w);
+				}
+
+				record_watches.erase(ev->wd);
+				continue;
+			}
+
+			// Only events about things inside the directory matter. Hidden
+			// files are never indexed, and come and go all the time (editor
+			// swap files and such), so they are ignored too.
+			if (ev->len == 0 || ev->name[0] == '\0')
+				continue;
+			if (ev->name[0] == '.' && !(ev->mask & IN_ISDIR))
+				continue;
+
+			DirNode* d = resolve(ev->wd);
+			if (d != NULL)
+				markDirty(d);
+		}
+	}
+}
+//==============================================================================
+
+
+//==============================================================================
+// Public methods.
+//==============================================================================
+bool TreeWatcher::isWatching()
+{
+	return fd >= 0;
+}
+
+bool TreeWatcher::isPolling()
+{
+	return polling;
+}
+
+int TreeWatcher::getNumWatches()
+{
+	return watches.size() + record_watches.size();
+}
+
+TreeChanges* TreeWatcher::poll()
+// Check for changes without blocking. Once a burst of events has died down
+// (or has gone on too long), the directories it touched are read again, and
+// what changed is handed back. The caller owns the change set, and must delete
+// it once nothing points at the removed nodes any more. Returns NULL if there
+// is nothing to report yet.
+{
+	if (fd >= 0)
+		readEvents();
+
+	double t = now();
+	TreeChanges* changes = NULL;
+
+	if (overflowed || (polling && t-last_poll >= WATCH_POLL_INTERVAL))
+	{
+		changes = new TreeChanges;
+		indexer->refresh(changes);
+
+		overflowed = false;
+		dirty.clear();
+		last_poll = t;
+	}
+	else if (!dirty.empty() && (t-last_event >= WATCH_SETTLE || t-first_event >= WATCH_MAX_DELAY))
+	{
+		list<DirNode*> dirs(dirty.begin(),dirty.end());
+		dirty.clear();
+
+		changes = new TreeChanges;
+		indexer->refreshDirectories(&dirs,changes);
+	}
+
+	if (changes == NULL)
+		return NULL;
+
+	// Stop watching what has gone, and start watching what is new. Anything
+	// created in a new directory before its watch was added would be missed,
+	// so new directories are read once more on the next round.
+	set<DirNode*>* gone = changes->getRemovedDirectories();
+	for (set<DirNode*>::iterator i = gone->begin(); i != gone->end(); i++)
+	{
+		forget(*i);
+		dirty.erase(*i);
+	}
+
+	list<DirNode*>* fresh = changes->getAddedDirectories();
+	for (list<DirNode*>::iterator i = fresh->begin(); i != fresh->end(); i++)
+	{
+		watchDirectory(*i);
+		markDirty(*i);
+	}
+
+	if (changes->isEmpty())
+	{
+		delete changes;
+		return NULL;
+	}
+
+	return changes;
+}
+//==============================================================================